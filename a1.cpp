@@ -1,11 +1,32 @@
 #include <iostream>
 #include <vector>
+#include <array>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <random>
 #include <chrono>
 #include <fstream>
 #include <utility>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <bit>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+
+#define STRINGSORT_COUNT_ALLOCATIONS 1
+#include "stringsort/instrumentation.hpp"
+#include "stringsort/io.hpp"
+#include "stringsort/mismatch.hpp"
+#include "stringsort/parallel_radix.hpp"
+
+using stringsort::PerfCounters;
+using stringsort::StringPool;
+using stringsort::allocated_bytes;
+using stringsort::allocation_count;
+using stringsort::findMismatch;
 
 class StringGenerator {
 private:
@@ -18,23 +39,30 @@ private:
         '!','@','#','%',':',';','^','&','*','(',')','-'
     };
 
+    // One engine per generator: the same (seed, stream) pair always yields
+    // the same datasets.
+    std::mt19937 gen_;
+
     std::string BuildRandomString(int min_len = 10, int max_len = 200) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
         std::uniform_int_distribution<> len_dist(min_len, max_len);
         std::uniform_int_distribution<> char_dist(0, kValidChars.size()-1);
         
-        int len = len_dist(gen);
+        int len = len_dist(gen_);
         std::string s;
         s.reserve(len);
         
         for (int i = 0; i < len; ++i) {
-            s.push_back(kValidChars[char_dist(gen)]);
+            s.push_back(kValidChars[char_dist(gen_)]);
         }
         return s;
     }
 
 public:
+    explicit StringGenerator(uint32_t seed, uint32_t stream = 0) {
+        std::seed_seq seq{seed, stream};
+        gen_.seed(seq);
+    }
+
     std::vector<std::string> CreateRandomDataset(int size) {
         std::vector<std::string> set(size);
         for (int i = 0; i < size; ++i) {
@@ -54,27 +82,22 @@ public:
         auto set = CreateRandomDataset(size);
         std::sort(set.begin(), set.end());
         
-        std::random_device rd;
-        std::mt19937 gen(rd());
         std::uniform_int_distribution<> dist(0, size-1);
-        
         for (int i = 0; i < size/20; ++i) {
-            std::swap(set[dist(gen)], set[dist(gen)]);
+            std::swap(set[dist(gen_)], set[dist(gen_)]);
         }
         return set;
     }
 
     std::vector<std::string> CreatePrefixDataset(int size) {
         std::vector<std::string> set(size);
-        std::random_device rd;
-        std::mt19937 gen(rd());
         std::uniform_int_distribution<> prefix_len(5, 15);
         
         for (int i = 0; i < 10; ++i) {
             std::string prefix;
-            int len = prefix_len(gen);
+            int len = prefix_len(gen_);
             for (int j = 0; j < len; ++j) {
-                prefix.push_back(kValidChars[gen() % kValidChars.size()]);
+                prefix.push_back(kValidChars[gen_() % kValidChars.size()]);
             }
             
             for (int j = i*size/10; j < (i+1)*size/10; ++j) {
@@ -82,24 +105,88 @@ public:
             }
         }
         
-        std::shuffle(set.begin(), set.end(), gen);
+        std::shuffle(set.begin(), set.end(), gen_);
         return set;
     }
+
+    std::vector<std::string> CreateDataset(const std::string& type, int size) {
+        if (type == "Reverse") return CreateReverseSortedDataset(size);
+        if (type == "NearlySorted") return CreateNearlySortedDataset(size);
+        if (type == "Prefix") return CreatePrefixDataset(size);
+        return CreateRandomDataset(size);
+    }
 };
 
 class StringSortTester {
 private:
     struct StringWithLCP {
-        std::string str;
-        int lcp;
+        std::string_view str;
+        size_t lcp;
     };
 
     struct PerformanceParams {
-        long long microseconds;
+        double microseconds;
         long long comparisons;
     };
 
+    // Filled during an instrumented run only. cmp_count keeps its historic
+    // meaning per algorithm; string_compares and char_inspections count the
+    // same thing in every algorithm. bytes_moved counts the bytes written
+    // into the arrays and temporary buffers, handles and string copies alike.
+    enum Phase { kHistogram, kDistribute, kPartition, kInsertion, kMerge, kPhaseCount };
+
+    struct SortStats {
+        std::array<double, kPhaseCount> phase_us{};
+        long long bytes_moved = 0;
+        long long string_compares = 0;
+        long long char_inspections = 0;
+    };
+
+    // The sorts below are templates on kInstrumented: the timed runs use the
+    // <false> instantiations, which carry no stats code at all, and only the
+    // instrumented run of RunBenchmarks uses <true>, which updates stats_.
+    SortStats* stats_ = nullptr;
+
+    // Adds the time until the end of the scope to one phase of stats_ when
+    // kInstrumented; does nothing otherwise.
+    template <bool kInstrumented>
+    class PhaseScope {
+    public:
+        PhaseScope(SortStats* stats, Phase phase) : stats_(stats), phase_(phase) {
+            if constexpr (kInstrumented) start_ = std::chrono::steady_clock::now();
+        }
+
+        ~PhaseScope() {
+            if constexpr (kInstrumented) {
+                stats_->phase_us[phase_] += std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start_).count();
+            }
+        }
+
+    private:
+        SortStats* stats_;
+        Phase phase_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    static const int kCharRange = 256;
+    using BucketCounts = std::array<int, kCharRange + 1>;
+    // Buckets the counting pass found non-empty; the permutation and the
+    // recursion visit only these.
+    using BucketMask = std::array<uint64_t, kCharRange / 64>;
+
+    template <typename Visit>
+    static void ForEachOccupied(const BucketMask& occupied, Visit visit) {
+        for (int word = 0; word < kCharRange / 64; ++word) {
+            for (uint64_t bits = occupied[word]; bits != 0; bits &= bits - 1) {
+                visit(word * 64 + std::countr_zero(bits));
+            }
+        }
+    }
+
+    template <bool kInstrumented>
     void Merge(std::vector<std::string>& arr, int l, int m, int r, long long& cmp_count) {
+        PhaseScope<kInstrumented> phase(stats_, kMerge);
         int n1 = m - l + 1;
         int n2 = r - m;
 
@@ -114,6 +201,7 @@ private:
 
         while (i < n1 && j < n2) {
             cmp_count++;
+            if constexpr (kInstrumented) stats_->string_compares++;
             if (L[i] <= R[j]) {
                 arr[k] = L[i];
                 i++;
@@ -135,375 +223,727 @@ private:
             j++;
             k++;
         }
+
+        if constexpr (kInstrumented) {
+            for (int t = l; t <= r; ++t) stats_->bytes_moved += 2 * (sizeof(std::string) + arr[t].size());
+        }
     }
 
+    template <bool kInstrumented>
     void MergeSort(std::vector<std::string>& arr, int l, int r, long long& cmp_count) {
         if (l >= r) return;
         int m = l + (r - l) / 2;
-        MergeSort(arr, l, m, cmp_count);
-        MergeSort(arr, m + 1, r, cmp_count);
-        Merge(arr, l, m, r, cmp_count);
+        MergeSort<kInstrumented>(arr, l, m, cmp_count);
+        MergeSort<kInstrumented>(arr, m + 1, r, cmp_count);
+        Merge<kInstrumented>(arr, l, m, r, cmp_count);
     }
 
+    template <bool kInstrumented>
     int Partition(std::vector<std::string>& arr, int low, int high, long long& cmp_count) {
+        PhaseScope<kInstrumented> phase(stats_, kPartition);
         std::string pivot = arr[high];
         int i = low - 1;
 
         for (int j = low; j <= high - 1; j++) {
             cmp_count++;
+            if constexpr (kInstrumented) stats_->string_compares++;
             if (arr[j] <= pivot) {
                 i++;
                 std::swap(arr[i], arr[j]);
+                if constexpr (kInstrumented) stats_->bytes_moved += 2 * sizeof(std::string);
             }
         }
         std::swap(arr[i + 1], arr[high]);
+        if constexpr (kInstrumented) stats_->bytes_moved += 2 * sizeof(std::string);
         return i + 1;
     }
 
+    template <bool kInstrumented>
     void QuickSort(std::vector<std::string>& arr, int low, int high, long long& cmp_count) {
         if (low < high) {
-            int pi = Partition(arr, low, high, cmp_count);
-            QuickSort(arr, low, pi - 1, cmp_count);
-            QuickSort(arr, pi + 1, high, cmp_count);
+            int pi = Partition<kInstrumented>(arr, low, high, cmp_count);
+            QuickSort<kInstrumented>(arr, low, pi - 1, cmp_count);
+            QuickSort<kInstrumented>(arr, pi + 1, high, cmp_count);
         }
     }
 
-    std::pair<int, int> CompareStrings(const std::string& a, const std::string& b, int depth, long long& cmp_count) {
-        int i = depth;
-        while (i < a.size() && i < b.size()) {
-            cmp_count++;
-            if (a[i] != b[i]) {
-                return {(a[i] < b[i]) ? -1 : 1, i};
-            }
-            i++;
+    template <bool kInstrumented>
+    std::pair<int, size_t> CompareStrings(std::string_view a, std::string_view b, size_t depth, long long& cmp_count) {
+        const size_t limit = std::min(a.size(), b.size());
+        const size_t i = depth >= limit ? limit : findMismatch(a.data(), b.data(), depth, limit);
+        cmp_count += i - std::min(depth, i) + 1;
+        if constexpr (kInstrumented) {
+            stats_->string_compares++;
+            stats_->char_inspections += i - std::min(depth, i) + 1;
         }
-        cmp_count++;
         if (i == a.size() && i == b.size()) return {0, i};
         if (i == a.size()) return {-1, i};
-        return {1, i};
+        if (i == b.size()) return {1, i};
+        return {(static_cast<unsigned char>(a[i]) < static_cast<unsigned char>(b[i])) ? -1 : 1, i};
     }
 
-    void MergeStrings(std::vector<StringWithLCP>& arr, int left, int mid, int right, long long& cmp_count) {
-        std::vector<StringWithLCP> left_part(arr.begin() + left, arr.begin() + mid + 1);
-        std::vector<StringWithLCP> right_part(arr.begin() + mid + 1, arr.begin() + right + 1);
-        
-        int i = 0, j = 0, k = left;
-        while (i < left_part.size() && j < right_part.size()) {
-            if (left_part[i].lcp > right_part[j].lcp) {
-                arr[k++] = left_part[i++];
+    // Only the left run is copied out to the scratch buffer: the output never
+    // overtakes the unread part of the right run, which is merged in place.
+    template <bool kInstrumented>
+    void MergeStrings(std::vector<StringWithLCP>& arr, std::vector<StringWithLCP>& scratch,
+                      int left, int mid, int right, long long& cmp_count) {
+        PhaseScope<kInstrumented> phase(stats_, kMerge);
+        if constexpr (kInstrumented) stats_->bytes_moved += (mid - left + 1 + right - left + 1) * sizeof(StringWithLCP);
+        std::copy(arr.begin() + left, arr.begin() + mid + 1, scratch.begin() + left);
+        
+        int i = left, j = mid + 1, k = left;
+        while (i <= mid && j <= right) {
+            if (scratch[i].lcp > arr[j].lcp) {
+                arr[k++] = scratch[i++];
             }
-            else if (left_part[i].lcp < right_part[j].lcp) {
-                arr[k++] = right_part[j++];
+            else if (scratch[i].lcp < arr[j].lcp) {
+                arr[k++] = arr[j++];
             }
             else {
-                auto [cmp, new_lcp] = CompareStrings(left_part[i].str, right_part[j].str, left_part[i].lcp, cmp_count);
+                auto [cmp, new_lcp] = CompareStrings<kInstrumented>(scratch[i].str, arr[j].str, scratch[i].lcp, cmp_count);
                 if (cmp == -1) {
-                    arr[k++] = left_part[i++];
-                    if (j < right_part.size()) right_part[j].lcp = new_lcp;
+                    arr[k++] = scratch[i++];
+                    arr[j].lcp = new_lcp;
                 }
                 else {
-                    arr[k++] = right_part[j++];
-                    if (i < left_part.size()) left_part[i].lcp = new_lcp;
+                    arr[k++] = arr[j++];
+                    if (i <= mid) scratch[i].lcp = new_lcp;
                 }
             }
         }
         
-        while (i < left_part.size()) arr[k++] = left_part[i++];
-        while (j < right_part.size()) arr[k++] = right_part[j++];
+        while (i <= mid) arr[k++] = scratch[i++];
     }
 
-    void MergeSortStrings(std::vector<StringWithLCP>& arr, int left, int right, long long& cmp_count) {
+    template <bool kInstrumented>
+    void MergeSortStrings(std::vector<StringWithLCP>& arr, std::vector<StringWithLCP>& scratch,
+                          int left, int right, long long& cmp_count) {
         if (left >= right) return;
         int mid = left + (right - left) / 2;
-        MergeSortStrings(arr, left, mid, cmp_count);
-        MergeSortStrings(arr, mid + 1, right, cmp_count);
-        MergeStrings(arr, left, mid, right, cmp_count);
+        MergeSortStrings<kInstrumented>(arr, scratch, left, mid, cmp_count);
+        MergeSortStrings<kInstrumented>(arr, scratch, mid + 1, right, cmp_count);
+        MergeStrings<kInstrumented>(arr, scratch, left, mid, right, cmp_count);
     }
 
-    void TernaryStringQuickSort(std::vector<std::string>& arr, int left, int right, int depth, long long& cmp_count) {
-        if (left >= right) return;
+    template <bool kInstrumented>
+    void MergeSortStrings(std::vector<StringWithLCP>& arr, int left, int right, long long& cmp_count) {
+        std::vector<StringWithLCP> scratch(arr.size());
+        MergeSortStrings<kInstrumented>(arr, scratch, left, right, cmp_count);
+    }
+
+    struct SortTask {
+        int left;
+        int right;
+        int depth;
+    };
+
+    static const int kInsertionSortThreshold = 16;
+    static const int kNintherThreshold = 64;
+
+    int CharAt(std::string_view str, int depth) {
+        return depth < static_cast<int>(str.size()) ? static_cast<unsigned char>(str[depth]) : -1;
+    }
+
+    int MedianOfThree(int a, int b, int c) {
+        return std::max(std::min(a, b), std::min(std::max(a, b), c));
+    }
+
+    int ChoosePivot(const std::vector<std::string_view>& arr, int left, int right, int depth, long long& cmp_count) {
+        auto at = [&](int i) { cmp_count++; return CharAt(arr[i], depth); };
+        int size = right - left + 1;
+        int mid = left + size / 2;
+        if (size < kNintherThreshold) return MedianOfThree(at(left), at(mid), at(right));
         
-        int pivot_pos = left;
-        for (int i = left; i <= right; ++i) {
-            if (arr[i].length() == depth) {
-                std::swap(arr[pivot_pos++], arr[i]);
+        int step = size / 8;
+        return MedianOfThree(MedianOfThree(at(left), at(left + step), at(left + 2 * step)),
+                             MedianOfThree(at(mid - step), at(mid), at(mid + step)),
+                             MedianOfThree(at(right - 2 * step), at(right - step), at(right)));
+    }
+
+    template <bool kInstrumented>
+    void InsertionSortSuffixes(std::vector<std::string_view>& arr, int left, int right, int depth, long long& cmp_count) {
+        PhaseScope<kInstrumented> phase(stats_, kInsertion);
+        for (int i = left + 1; i <= right; ++i) {
+            std::string_view key = arr[i];
+            int j = i - 1;
+            while (j >= left && CompareStrings<kInstrumented>(arr[j], key, depth, cmp_count).first > 0) {
+                arr[j + 1] = arr[j];
+                j--;
             }
+            arr[j + 1] = key;
+            if constexpr (kInstrumented) stats_->bytes_moved += (i - j) * sizeof(std::string_view);
         }
+    }
+
+    template <bool kInstrumented>
+    void TernaryStringQuickSort(std::vector<std::string_view>& arr, int left, int right, int depth, long long& cmp_count) {
+        std::vector<SortTask> stack = {{left, right, depth}};
         
-        if (pivot_pos > right) return;
-        
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dist(pivot_pos, right);
-        std::swap(arr[pivot_pos], arr[dist(gen)]);
-        char pivot = arr[pivot_pos][depth];
-        
-        int lt = pivot_pos;
-        int gt = right;
-        int i = pivot_pos + 1;
-        
-        while (i <= gt) {
-            cmp_count++;
-            if (arr[i][depth] < pivot) {
-                std::swap(arr[lt++], arr[i++]);
+        while (!stack.empty()) {
+            SortTask task = stack.back();
+            stack.pop_back();
+            
+            while (task.right - task.left + 1 > kInsertionSortThreshold) {
+                PhaseScope<kInstrumented> phase(stats_, kPartition);
+                int pivot = ChoosePivot(arr, task.left, task.right, task.depth, cmp_count);
+                int lt = task.left;
+                int gt = task.right;
+                int i = task.left;
+                
+                while (i <= gt) {
+                    cmp_count++;
+                    if constexpr (kInstrumented) stats_->char_inspections++;
+                    int c = CharAt(arr[i], task.depth);
+                    if (c < pivot) {
+                        std::swap(arr[lt++], arr[i++]);
+                        if constexpr (kInstrumented) stats_->bytes_moved += 2 * sizeof(std::string_view);
+                    }
+                    else if (c > pivot) {
+                        std::swap(arr[i], arr[gt--]);
+                        if constexpr (kInstrumented) stats_->bytes_moved += 2 * sizeof(std::string_view);
+                    }
+                    else {
+                        i++;
+                    }
+                }
+                
+                SortTask parts[3] = {
+                    {task.left, lt - 1, task.depth},
+                    {lt, pivot < 0 ? lt - 1 : gt, task.depth + 1},
+                    {gt + 1, task.right, task.depth}
+                };
+                std::sort(parts, parts + 3, [](const SortTask& a, const SortTask& b) {
+                    return a.right - a.left < b.right - b.left;
+                });
+                if (parts[2].left < parts[2].right) stack.push_back(parts[2]);
+                if (parts[1].left < parts[1].right) stack.push_back(parts[1]);
+                task = parts[0];
             }
-            else if (arr[i][depth] > pivot) {
-                std::swap(arr[i], arr[gt--]);
+            
+            InsertionSortSuffixes<kInstrumented>(arr, task.left, task.right, task.depth, cmp_count);
+        }
+    }
+
+    template <bool kInstrumented>
+    int RadixPartition(std::vector<std::string_view>& arr, int left, int right, int depth, BucketCounts& count,
+                       BucketMask& occupied, long long& cmp_count) {
+        int pivot_pos = left;
+        {
+            PhaseScope<kInstrumented> phase(stats_, kHistogram);
+            for (int i = left; i <= right; ++i) {
+                if (arr[i].length() == static_cast<size_t>(depth)) {
+                    std::swap(arr[pivot_pos++], arr[i]);
+                    if constexpr (kInstrumented) stats_->bytes_moved += 2 * sizeof(std::string_view);
+                }
             }
-            else {
-                i++;
+            
+            if (pivot_pos > right) return pivot_pos;
+            
+            for (int i = pivot_pos; i <= right; ++i) {
+                cmp_count++;
+                unsigned char c = arr[i][depth];
+                count[c + 1]++;
+                occupied[c / 64] |= uint64_t(1) << (c % 64);
+            }
+            if constexpr (kInstrumented) stats_->char_inspections += right - pivot_pos + 1;
+            
+            for (int i = 1; i <= kCharRange; ++i) {
+                count[i] += count[i - 1];
             }
         }
         
-        TernaryStringQuickSort(arr, left, lt - 1, depth, cmp_count);
-        TernaryStringQuickSort(arr, lt, gt, depth + 1, cmp_count);
-        TernaryStringQuickSort(arr, gt + 1, right, depth, cmp_count);
+        PhaseScope<kInstrumented> phase(stats_, kDistribute);
+        
+        // American flag permutation: follow each displaced string's cycle
+        // until it reaches its own bucket, so no temporary buffer is needed.
+        std::array<int, kCharRange> next_free;
+        std::copy(count.begin(), count.end() - 1, next_free.begin());
+        ForEachOccupied(occupied, [&](int bucket) {
+            while (next_free[bucket] < count[bucket + 1]) {
+                std::string_view current = arr[pivot_pos + next_free[bucket]];
+                cmp_count++;
+                int c = static_cast<unsigned char>(current[depth]);
+                while (c != bucket) {
+                    std::swap(current, arr[pivot_pos + next_free[c]++]);
+                    cmp_count++;
+                    if constexpr (kInstrumented) {
+                        stats_->char_inspections++;
+                        stats_->bytes_moved += sizeof(std::string_view);
+                    }
+                    c = static_cast<unsigned char>(current[depth]);
+                }
+                arr[pivot_pos + next_free[bucket]++] = current;
+                if constexpr (kInstrumented) {
+                    stats_->char_inspections++;
+                    stats_->bytes_moved += sizeof(std::string_view);
+                }
+            }
+        });
+        return pivot_pos;
     }
 
-    void MSDRadixSort(std::vector<std::string>& arr, int left, int right, int depth, long long& cmp_count) {
+    template <bool kInstrumented>
+    void MSDRadixSort(std::vector<std::string_view>& arr, int left, int right, int depth, long long& cmp_count) {
         if (left >= right) return;
         
-        int pivot_pos = left;
-        for (int i = left; i <= right; ++i) {
-            if (arr[i].length() == depth) {
-                std::swap(arr[pivot_pos++], arr[i]);
-            }
-        }
-        
+        BucketCounts count{};
+        BucketMask occupied{};
+        int pivot_pos = RadixPartition<kInstrumented>(arr, left, right, depth, count, occupied, cmp_count);
         if (pivot_pos > right) return;
         
-        const int kCharRange = 256;
-        std::vector<int> count(kCharRange + 1, 0);
-        
-        for (int i = pivot_pos; i <= right; ++i) {
-            cmp_count++;
-            count[static_cast<unsigned char>(arr[i][depth]) + 1]++;
-        }
-        
-        for (int i = 1; i <= kCharRange; ++i) {
-            count[i] += count[i - 1];
-        }
-        
-        std::vector<std::string> temp(right - pivot_pos + 1);
-        for (int i = pivot_pos; i <= right; ++i) {
-            cmp_count++;
-            temp[count[arr[i][depth]]++] = arr[i];
-        }
-        
-        for (int i = 0; i < temp.size(); ++i) {
-            arr[pivot_pos + i] = temp[i];
-        }
-        
-        for (int i = 0; i < kCharRange; ++i) {
+        ForEachOccupied(occupied, [&](int i) {
             int new_left = pivot_pos + count[i];
             int new_right = pivot_pos + count[i + 1] - 1;
-            MSDRadixSort(arr, new_left, new_right, depth + 1, cmp_count);
-        }
+            if (new_left < new_right) MSDRadixSort<kInstrumented>(arr, new_left, new_right, depth + 1, cmp_count);
+        });
     }
 
-    void RadixQuickSort(std::vector<std::string>& arr, int left, int right, int depth, long long& cmp_count) {
+    template <bool kInstrumented>
+    void RadixQuickSort(std::vector<std::string_view>& arr, int left, int right, int depth, long long& cmp_count) {
         if (left >= right) return;
         
         if (right - left + 1 < 74) {
-            TernaryStringQuickSort(arr, left, right, depth, cmp_count);
+            TernaryStringQuickSort<kInstrumented>(arr, left, right, depth, cmp_count);
             return;
         }
         
-        int pivot_pos = left;
-        for (int i = left; i <= right; ++i) {
-            if (arr[i].length() == depth) {
-                std::swap(arr[pivot_pos++], arr[i]);
-            }
-        }
-        
+        BucketCounts count{};
+        BucketMask occupied{};
+        int pivot_pos = RadixPartition<kInstrumented>(arr, left, right, depth, count, occupied, cmp_count);
         if (pivot_pos > right) return;
         
-        const int kCharRange = 256;
-        std::vector<int> count(kCharRange + 1, 0);
-        
-        for (int i = pivot_pos; i <= right; ++i) {
-            cmp_count++;
-            count[static_cast<unsigned char>(arr[i][depth]) + 1]++;
-        }
-        
-        for (int i = 1; i <= kCharRange; ++i) {
-            count[i] += count[i - 1];
-        }
-        
-        std::vector<std::string> temp(right - pivot_pos + 1);
-        for (int i = pivot_pos; i <= right; ++i) {
-            cmp_count++;
-            temp[count[arr[i][depth]]++] = arr[i];
-        }
-        
-        for (int i = 0; i < temp.size(); ++i) {
-            arr[pivot_pos + i] = temp[i];
-        }
-        
-        for (int i = 0; i < kCharRange; ++i) {
+        ForEachOccupied(occupied, [&](int i) {
             int new_left = pivot_pos + count[i];
             int new_right = pivot_pos + count[i + 1] - 1;
-            RadixQuickSort(arr, new_left, new_right, depth + 1, cmp_count);
-        }
+            if (new_left < new_right) RadixQuickSort<kInstrumented>(arr, new_left, new_right, depth + 1, cmp_count);
+        });
     }
 
+    template <bool kInstrumented>
     PerformanceParams TestStandardMergeSort(std::vector<std::string> data) {
         long long cmp_count = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        MergeSort(data, 0, data.size()-1, cmp_count);
-        auto end = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
+        MergeSort<kInstrumented>(data, 0, data.size()-1, cmp_count);
+        auto end = std::chrono::steady_clock::now();
         
         return {
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+            std::chrono::duration<double, std::micro>(end - start).count(),
             cmp_count
         };
     }
 
+    template <bool kInstrumented>
     PerformanceParams TestStandardQuickSort(std::vector<std::string> data) {
         long long cmp_count = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        QuickSort(data, 0, data.size()-1, cmp_count);
-        auto end = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
+        QuickSort<kInstrumented>(data, 0, data.size()-1, cmp_count);
+        auto end = std::chrono::steady_clock::now();
         
         return {
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+            std::chrono::duration<double, std::micro>(end - start).count(),
             cmp_count
         };
     }
 
-    PerformanceParams TestStringMergeSort(std::vector<std::string> data) {
-        std::vector<StringWithLCP> lcp_data(data.size());
-        for (size_t i = 0; i < data.size(); ++i) {
-            lcp_data[i] = {data[i], 0};
+    // Copies the dataset into one arena, so the sorts move views, not strings.
+    static StringPool MakePool(const std::vector<std::string>& strings) {
+        StringPool pool;
+        pool.reserve(strings.size());
+        for (const auto& s : strings) pool.append(s);
+        return pool;
+    }
+
+    template <bool kInstrumented>
+    PerformanceParams TestStringMergeSort(const std::vector<std::string>& data) {
+        StringPool pool = MakePool(data);
+        std::vector<std::string_view> views = pool.views();
+        std::vector<StringWithLCP> lcp_data(views.size());
+        for (size_t i = 0; i < views.size(); ++i) {
+            lcp_data[i] = {views[i], 0};
         }
         
         long long cmp_count = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        MergeSortStrings(lcp_data, 0, lcp_data.size()-1, cmp_count);
-        for (size_t i = 0; i < data.size(); ++i) {
-            data[i] = lcp_data[i].str;
+        auto start = std::chrono::steady_clock::now();
+        MergeSortStrings<kInstrumented>(lcp_data, 0, lcp_data.size()-1, cmp_count);
+        for (size_t i = 0; i < views.size(); ++i) {
+            views[i] = lcp_data[i].str;
         }
-        auto end = std::chrono::high_resolution_clock::now();
+        auto end = std::chrono::steady_clock::now();
         
         return {
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+            std::chrono::duration<double, std::micro>(end - start).count(),
             cmp_count
         };
     }
 
-    PerformanceParams TestStringQuickSort(std::vector<std::string> data) {
+    template <bool kInstrumented>
+    PerformanceParams TestStringQuickSort(const std::vector<std::string>& data) {
+        StringPool pool = MakePool(data);
+        std::vector<std::string_view> views = pool.views();
         long long cmp_count = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        TernaryStringQuickSort(data, 0, data.size()-1, 0, cmp_count);
-        auto end = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
+        TernaryStringQuickSort<kInstrumented>(views, 0, views.size()-1, 0, cmp_count);
+        auto end = std::chrono::steady_clock::now();
         
         return {
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+            std::chrono::duration<double, std::micro>(end - start).count(),
             cmp_count
         };
     }
 
-    PerformanceParams TestMSDRadixSort(std::vector<std::string> data) {
+    template <bool kInstrumented>
+    PerformanceParams TestMSDRadixSort(const std::vector<std::string>& data) {
+        StringPool pool = MakePool(data);
+        std::vector<std::string_view> views = pool.views();
         long long cmp_count = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        MSDRadixSort(data, 0, data.size()-1, 0, cmp_count);
-        auto end = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
+        MSDRadixSort<kInstrumented>(views, 0, views.size()-1, 0, cmp_count);
+        auto end = std::chrono::steady_clock::now();
         
         return {
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+            std::chrono::duration<double, std::micro>(end - start).count(),
             cmp_count
         };
     }
 
-    PerformanceParams TestRadixQuickSort(std::vector<std::string> data) {
+    template <bool kInstrumented>
+    PerformanceParams TestRadixQuickSort(const std::vector<std::string>& data) {
+        StringPool pool = MakePool(data);
+        std::vector<std::string_view> views = pool.views();
         long long cmp_count = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        RadixQuickSort(data, 0, data.size()-1, 0, cmp_count);
-        auto end = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
+        RadixQuickSort<kInstrumented>(views, 0, views.size()-1, 0, cmp_count);
+        auto end = std::chrono::steady_clock::now();
         
         return {
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+            std::chrono::duration<double, std::micro>(end - start).count(),
             cmp_count
         };
     }
 
-    void testDataset(int size, 
-                    const std::vector<std::vector<std::string>>& datasets,
-                    const std::vector<std::string>& labels, 
-                    int runs,
-                    std::ofstream& time_log, 
-                    std::ofstream& comp_log) {
-        for (size_t i = 0; i < labels.size(); ++i) {
-            std::vector<long long> time_stats(6, 0);
-            std::vector<long long> comp_stats(6, 0);
-            
-            for (int j = 0; j < runs; ++j) {
-                auto res1 = TestStandardMergeSort(datasets[i]);
-                auto res2 = TestStandardQuickSort(datasets[i]);
-                auto res3 = TestStringMergeSort(datasets[i]);
-                auto res4 = TestStringQuickSort(datasets[i]);
-                auto res5 = TestMSDRadixSort(datasets[i]);
-                auto res6 = TestRadixQuickSort(datasets[i]);
-                
-                time_stats[0] += res1.microseconds;
-                time_stats[1] += res2.microseconds;
-                time_stats[2] += res3.microseconds;
-                time_stats[3] += res4.microseconds;
-                time_stats[4] += res5.microseconds;
-                time_stats[5] += res6.microseconds;
-                
-                comp_stats[0] += res1.comparisons;
-                comp_stats[1] += res2.comparisons;
-                comp_stats[2] += res3.comparisons;
-                comp_stats[3] += res4.comparisons;
-                comp_stats[4] += res5.comparisons;
-                comp_stats[5] += res6.comparisons;
-            }
-            
-            time_log << size << "," << labels[i];
-            comp_log << size << "," << labels[i];
-            
-            for (int k = 0; k < 6; ++k) {
-                time_log << "," << (time_stats[k] / runs);
-                comp_log << "," << (comp_stats[k] / runs);
-            }
-            
-            time_log << "\n";
-            comp_log << "\n";
+    PerformanceParams TestParallelRadixQuickSort(const std::vector<std::string>& data, int thread_count) {
+        StringPool pool = MakePool(data);
+        std::vector<std::string_view> views = pool.views();
+        auto start = std::chrono::steady_clock::now();
+        stringsort::parallelRadixQuickSort(views.begin(), views.end(), thread_count);
+        auto end = std::chrono::steady_clock::now();
+        
+        return {
+            std::chrono::duration<double, std::micro>(end - start).count(),
+            0
+        };
+    }
+
+    struct Algorithm {
+        std::string name;
+        std::function<PerformanceParams(const std::vector<std::string>&)> run;
+        // Larger inputs are skipped; 0 means no limit. The textbook QuickSort
+        // degrades to O(n^2) time and O(n) recursion depth on sorted input.
+        int max_size;
+    };
+
+    template <bool kInstrumented>
+    std::vector<Algorithm> Algorithms() {
+        return {
+            {"StandardMerge", [this](const std::vector<std::string>& d) { return TestStandardMergeSort<kInstrumented>(d); }, 0},
+            {"StandardQuick", [this](const std::vector<std::string>& d) { return TestStandardQuickSort<kInstrumented>(d); }, 10000},
+            {"CustomMerge", [this](const std::vector<std::string>& d) { return TestStringMergeSort<kInstrumented>(d); }, 0},
+            {"CustomQuick", [this](const std::vector<std::string>& d) { return TestStringQuickSort<kInstrumented>(d); }, 0},
+            {"Radix", [this](const std::vector<std::string>& d) { return TestMSDRadixSort<kInstrumented>(d); }, 0},
+            {"RadixQuick", [this](const std::vector<std::string>& d) { return TestRadixQuickSort<kInstrumented>(d); }, 0}
+        };
+    }
+
+    struct Summary {
+        double median;
+        double p95;
+        double mean;
+        double stddev;
+    };
+
+    static double Percentile(const std::vector<double>& sorted, double fraction) {
+        const double position = fraction * (sorted.size() - 1);
+        const size_t lower = static_cast<size_t>(position);
+        const size_t upper = std::min(lower + 1, sorted.size() - 1);
+        return sorted[lower] + (position - lower) * (sorted[upper] - sorted[lower]);
+    }
+
+    static Summary Summarize(std::vector<double> samples) {
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double x : samples) sum += x;
+        const double mean = sum / samples.size();
+        double squares = 0;
+        for (double x : samples) squares += (x - mean) * (x - mean);
+        const double stddev = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0.0;
+        return {Percentile(samples, 0.5), Percentile(samples, 0.95), mean, stddev};
+    }
+
+    static bool Selected(const std::vector<std::string>& filter, const std::string& name) {
+        return filter.empty() || std::find(filter.begin(), filter.end(), name) != filter.end();
+    }
+
+    void WriteInstrumentedRun(const Algorithm& algorithm, const std::string& type,
+                              const std::vector<std::string>& data,
+                              PerfCounters& perfCounters, std::ofstream& out) {
+        SortStats stats;
+        stats_ = &stats;
+        const long long allocationsBefore = allocation_count.load();
+        const long long bytesBefore = allocated_bytes.load();
+        const PerfCounters::Values countersBefore = perfCounters.read();
+        PerformanceParams result = algorithm.run(data);
+        PerfCounters::Values counters = perfCounters.read();
+        const long long allocations = allocation_count.load() - allocationsBefore;
+        const long long allocatedBytes = allocated_bytes.load() - bytesBefore;
+        for (size_t i = 0; i < counters.size(); ++i) {
+            if (counters[i] >= 0) counters[i] -= countersBefore[i];
+        }
+        stats_ = nullptr;
+        
+        double phaseTotal = 0;
+        for (double us : stats.phase_us) phaseTotal += us;
+        
+        out << data.size() << "," << type << "," << algorithm.name << "," << result.microseconds;
+        for (double us : stats.phase_us) out << "," << us;
+        out << "," << std::max(0.0, result.microseconds - phaseTotal)
+            << "," << allocations << "," << allocatedBytes << "," << stats.bytes_moved
+            << "," << stats.string_compares << "," << stats.char_inspections;
+        for (long long value : counters) {
+            out << ",";
+            if (value >= 0) out << value;
         }
     }
 
 public:
-    void RunTests() {
-        StringGenerator dataGenerator;
-        const std::vector<int> testSizes = {100,200,300,400,500,600,700,800,900,1000,
-                                          1500,2000,2500,3000};
-        const int numTestRuns = 3;
+    struct BenchmarkOptions {
+        uint32_t seed = 42;
+        int min_size = 100;
+        int max_size = 100000;
+        double growth = 2.0;
+        int warmup_runs = 1;
+        int runs = 11;
+        std::vector<std::string> algorithms;
+        std::vector<std::string> types;
+        std::string format = "csv";
+        bool instrument = false;
+    };
+
+    // Geometric sweep from min_size to max_size. For every size and dataset
+    // type the data comes from a generator seeded with (seed, size, type),
+    // so a run can be repeated exactly and filters do not change the data.
+    // Every algorithm gets warmup_runs untimed runs and then `runs` timed
+    // ones. Medians go to microseconds_results.csv / comparisons_results.csv
+    // in the layout plots.py reads (skipped cells are left empty); the full
+    // statistics go to benchmark_results.csv or benchmark_results.json.
+    // With options.instrument every algorithm gets one more, instrumented
+    // run whose phases, allocations, bytes moved and hardware counters go to
+    // instrumentation_results.csv; the timed runs are not instrumented.
+    void RunBenchmarks(const BenchmarkOptions& options) {
+        const std::vector<std::string> datasetTypes = {"Random", "Reverse", "NearlySorted", "Prefix"};
+        const std::vector<Algorithm> algorithms = Algorithms<false>();
+        const std::vector<Algorithm> instrumentedAlgorithms = Algorithms<true>();
+        
+        std::vector<int> testSizes;
+        for (double size = options.min_size; size <= options.max_size * 1.0000001; size *= options.growth) {
+            if (testSizes.empty() || static_cast<int>(size) != testSizes.back()) {
+                testSizes.push_back(static_cast<int>(size));
+            }
+            if (options.growth <= 1.0) break;
+        }
         
         std::ofstream timeResultsFile("microseconds_results.csv");
         std::ofstream compResultsFile("comparisons_results.csv");
+        timeResultsFile << "Size,Type";
+        compResultsFile << "Size,Type";
+        for (const Algorithm& algorithm : algorithms) {
+            timeResultsFile << "," << algorithm.name;
+            compResultsFile << "," << algorithm.name;
+        }
+        timeResultsFile << "\n";
+        compResultsFile << "\n";
+        
+        const bool json = options.format == "json";
+        std::ofstream detailsFile(json ? "benchmark_results.json" : "benchmark_results.csv");
+        if (json) {
+            detailsFile << "{\"seed\": " << options.seed << ", \"warmup_runs\": " << options.warmup_runs
+                        << ", \"runs\": " << options.runs << ", \"results\": [";
+        } else {
+            detailsFile << "Size,Type,Algorithm,Runs,MedianUs,P95Us,MeanUs,StddevUs,Comparisons\n";
+        }
+        bool firstRecord = true;
+        
+        std::ofstream instrumentationFile;
+        PerfCounters perfCounters;
+        if (options.instrument) {
+            instrumentationFile.open("instrumentation_results.csv");
+            instrumentationFile << "Size,Type,Algorithm,TotalUs,HistogramUs,DistributeUs,PartitionUs,"
+                                << "InsertionUs,MergeUs,OtherUs,Allocations,AllocatedBytes,BytesMoved,"
+                                << "StringCompares,CharInspections,Cycles,Instructions,CacheMisses,BranchMisses\n";
+            if (!perfCounters.available()) {
+                std::cerr << "perf events unavailable, hardware counter columns are left empty\n";
+            }
+        }
         
-        timeResultsFile << "Size,Type,StandardMerge,StandardQuick,CustomMerge,CustomQuick,Radix,RadixQuick\n";
-        compResultsFile << "Size,Type,StandardMerge,StandardQuick,CustomMerge,CustomQuick,Radix,RadixQuick\n";
+        for (int currentSize : testSizes) {
+            std::cout << "Current size of dataset: " << currentSize << std::endl;
+            
+            for (size_t type = 0; type < datasetTypes.size(); ++type) {
+                if (!Selected(options.types, datasetTypes[type])) continue;
+                StringGenerator dataGenerator(options.seed, currentSize * 4u + type);
+                const std::vector<std::string> data = dataGenerator.CreateDataset(datasetTypes[type], currentSize);
+                
+                timeResultsFile << currentSize << "," << datasetTypes[type];
+                compResultsFile << currentSize << "," << datasetTypes[type];
+                for (size_t index = 0; index < algorithms.size(); ++index) {
+                    const Algorithm& algorithm = algorithms[index];
+                    timeResultsFile << ",";
+                    compResultsFile << ",";
+                    if (!Selected(options.algorithms, algorithm.name) ||
+                        (algorithm.max_size > 0 && currentSize > algorithm.max_size)) {
+                        continue;
+                    }
+                    
+                    for (int j = 0; j < options.warmup_runs; ++j) {
+                        algorithm.run(data);
+                    }
+                    std::vector<double> samples;
+                    long long comparisons = 0;
+                    for (int j = 0; j < options.runs; ++j) {
+                        PerformanceParams result = algorithm.run(data);
+                        samples.push_back(result.microseconds);
+                        comparisons = result.comparisons;
+                    }
+                    const Summary summary = Summarize(samples);
+                    
+                    timeResultsFile << summary.median;
+                    compResultsFile << comparisons;
+                    if (json) {
+                        detailsFile << (firstRecord ? "\n  " : ",\n  ")
+                                    << "{\"size\": " << currentSize << ", \"type\": \"" << datasetTypes[type]
+                                    << "\", \"algorithm\": \"" << algorithm.name << "\", \"runs\": " << options.runs
+                                    << ", \"median_us\": " << summary.median << ", \"p95_us\": " << summary.p95
+                                    << ", \"mean_us\": " << summary.mean << ", \"stddev_us\": " << summary.stddev
+                                    << ", \"comparisons\": " << comparisons << "}";
+                    } else {
+                        detailsFile << currentSize << "," << datasetTypes[type] << "," << algorithm.name << ","
+                                    << options.runs << "," << summary.median << "," << summary.p95 << ","
+                                    << summary.mean << "," << summary.stddev << "," << comparisons << "\n";
+                    }
+                    firstRecord = false;
+                    
+                    if (options.instrument) {
+                        WriteInstrumentedRun(instrumentedAlgorithms[index], datasetTypes[type], data, perfCounters,
+                                             instrumentationFile);
+                        instrumentationFile << "\n";
+                    }
+                }
+                timeResultsFile << "\n";
+                compResultsFile << "\n";
+            }
+        }
+        
+        if (json) {
+            detailsFile << "\n]}\n";
+        }
+    }
+
+    void RunSpeedupTests(const BenchmarkOptions& options) {
+        const std::vector<int> testSizes = {100000, 1000000};
+        const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        
+        std::vector<int> threadCounts;
+        for (int threads = 1; threads < maxThreads; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+        
+        std::ofstream speedupResultsFile("speedup_results.csv");
+        speedupResultsFile << "Size,Type,Threads,Microseconds,Speedup\n";
         
         for (int currentSize : testSizes) {
             std::cout << "Current size of dataset: " << currentSize << std::endl;
             
             std::vector<std::string> datasetTypes = {"Random", "Reverse", "NearlySorted", "Prefix"};
-            std::vector<std::vector<std::string>> testData = {
-                dataGenerator.CreateRandomDataset(currentSize),
-                dataGenerator.CreateReverseSortedDataset(currentSize),
-                dataGenerator.CreateNearlySortedDataset(currentSize),
-                dataGenerator.CreatePrefixDataset(currentSize)
-            };
-            
-            testDataset(currentSize, testData, datasetTypes, numTestRuns, timeResultsFile, compResultsFile);
+            for (size_t i = 0; i < datasetTypes.size(); ++i) {
+                if (!Selected(options.types, datasetTypes[i])) continue;
+                StringGenerator dataGenerator(options.seed, currentSize * 4u + i);
+                const std::vector<std::string> data = dataGenerator.CreateDataset(datasetTypes[i], currentSize);
+                
+                double baseline = 0;
+                for (int threads : threadCounts) {
+                    for (int j = 0; j < options.warmup_runs; ++j) {
+                        TestParallelRadixQuickSort(data, threads);
+                    }
+                    std::vector<double> samples;
+                    for (int j = 0; j < options.runs; ++j) {
+                        samples.push_back(TestParallelRadixQuickSort(data, threads).microseconds);
+                    }
+                    double median = std::max(Summarize(samples).median, 1.0);
+                    if (threads == 1) baseline = median;
+                    
+                    speedupResultsFile << currentSize << "," << datasetTypes[i] << "," << threads << ","
+                                       << median << "," << baseline / median << "\n";
+                }
+            }
         }
     }
 };
 
-int main() {
+std::vector<std::string> SplitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > start) items.push_back(list.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+int main(int argc, char* argv[]) {
     StringSortTester tester;
-    tester.RunTests();
+    StringSortTester::BenchmarkOptions options;
+    bool speedup = false;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--speedup") {
+            speedup = true;
+        } else if (arg == "--instrument") {
+            options.instrument = true;
+        } else if (arg == "--seed" && has_value) {
+            options.seed = std::stoul(argv[++i]);
+        } else if (arg == "--min-size" && has_value) {
+            options.min_size = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--max-size" && has_value) {
+            options.max_size = std::stoi(argv[++i]);
+        } else if (arg == "--growth" && has_value) {
+            options.growth = std::stod(argv[++i]);
+        } else if (arg == "--warmup" && has_value) {
+            options.warmup_runs = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--runs" && has_value) {
+            options.runs = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--algorithms" && has_value) {
+            options.algorithms = SplitList(argv[++i]);
+        } else if (arg == "--types" && has_value) {
+            options.types = SplitList(argv[++i]);
+        } else if (arg == "--format" && has_value && 
+                   (std::string(argv[i + 1]) == "csv" || std::string(argv[i + 1]) == "json")) {
+            options.format = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--speedup] [--seed S] [--min-size N] [--max-size N]"
+                      << " [--growth F] [--warmup N] [--runs N] [--algorithms A,B,...]"
+                      << " [--types Random,Reverse,NearlySorted,Prefix] [--format csv|json] [--instrument]\n";
+            return 1;
+        }
+    }
+    
+    if (speedup) {
+        tester.RunSpeedupTests(options);
+    } else {
+        tester.RunBenchmarks(options);
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -2,153 +2,490 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+#include <cstdint>
 
-using StringWithLCP = std::pair<std::string, int>;
+#define STRINGSORT_COUNT_ALLOCATIONS 1
+#include "stringsort/instrumentation.hpp"
+#include "stringsort/io.hpp"
+#include "stringsort/lcp_merge_sort.hpp"
+#include "stringsort/loser_tree.hpp"
 
-std::pair<int, int> compareStringsByLCP(const std::string& first_str, 
-                                      const std::string& second_str, 
-                                      int start_from) {
-    int lcp_length = start_from;
-    const int first_len = first_str.length();
-    const int second_len = second_str.length();
-    
-    while (lcp_length < first_len && 
-           lcp_length < second_len && 
-           first_str[lcp_length] == second_str[lcp_length]) {
-        lcp_length++;
+using stringsort::FileSource;
+using stringsort::LcpLoserTree;
+using stringsort::PhaseLog;
+using stringsort::SortedSource;
+using stringsort::StringPool;
+using stringsort::StringWithLCP;
+using stringsort::compareStringsByLCP;
+using stringsort::mergeSortedParts;
+using stringsort::performMergeSort;
+using stringsort::readInputStrings;
+
+const size_t parallel_merge_cutoff = 1 << 14;
+
+// Merge-path co-ranking: how many elements of a are among the first
+// `diagonal` elements of the stable merge of a and b.
+size_t coRank(const StringWithLCP* a, size_t a_size, 
+              const StringWithLCP* b, size_t b_size, size_t diagonal) {
+    size_t low = diagonal > b_size ? diagonal - b_size : 0;
+    size_t high = std::min(diagonal, a_size);
+    while (low < high) {
+        const size_t a_count = low + (high - low) / 2;
+        if (compareStringsByLCP(a[a_count].str, b[diagonal - a_count - 1].str, 0).first <= 0) 
+            low = a_count + 1;
+        else 
+            high = a_count;
     }
+    return low;
+}
+
+// Writes out[begin, end) of the merge of a and b. The split points are found
+// by co-ranking, and the LCPs of the first two heads are recomputed against
+// the string that precedes out[begin], so the LCP array stays exact across
+// segment borders.
+void mergeSegment(const StringWithLCP* a, size_t a_size, 
+                  const StringWithLCP* b, size_t b_size,
+                  StringWithLCP* out, size_t begin, size_t end) {
+    const size_t a_begin = coRank(a, a_size, b, b_size, begin);
+    const size_t b_begin = begin - a_begin;
+    const size_t a_end = coRank(a, a_size, b, b_size, end);
+    const size_t b_end = end - a_end;
     
-    if (lcp_length == first_len && lcp_length == second_len) 
-        return {0, lcp_length};
-    if (lcp_length == first_len) 
-        return {-1, lcp_length};
-    if (lcp_length == second_len) 
-        return {1, lcp_length};
+    size_t a_head = 0;
+    size_t b_head = 0;
+    if (begin > 0) {
+        bool previous_from_a = b_begin == 0 || 
+            (a_begin > 0 && compareStringsByLCP(a[a_begin - 1].str, b[b_begin - 1].str, 0).first > 0);
+        std::string_view previous = previous_from_a ? a[a_begin - 1].str : b[b_begin - 1].str;
+        if (a_begin < a_size) {
+            a_head = previous_from_a ? a[a_begin].lcp : 
+                     compareStringsByLCP(a[a_begin].str, previous, 0).second;
+        }
+        if (b_begin < b_size) {
+            b_head = !previous_from_a ? b[b_begin].lcp : 
+                     compareStringsByLCP(b[b_begin].str, previous, 0).second;
+        }
+    }
     
-    return (first_str[lcp_length] < second_str[lcp_length]) ? 
-           std::make_pair(-1, lcp_length) : 
-           std::make_pair(1, lcp_length);
+    mergeSortedParts(a + a_begin, a_end - a_begin, a_head, 
+                     b + b_begin, b_end - b_begin, b_head, out + begin);
 }
 
-void copyStringRange(const std::vector<StringWithLCP>& source,
-                    std::vector<StringWithLCP>& destination,
-                    int start_idx, 
-                    int end_idx) {
-    int current_pos = 0;
-    while (start_idx <= end_idx) {
-        destination[current_pos] = source[start_idx];
-        start_idx++;
-        current_pos++;
+void runTasks(const std::vector<std::function<void()>>& tasks, int thread_count) {
+    std::atomic<size_t> next_task{0};
+    auto worker = [&tasks, &next_task] {
+        size_t task = next_task++;
+        while (task < tasks.size()) {
+            tasks[task]();
+            task = next_task++;
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    int i = 1;
+    while (i < thread_count) {
+        threads.emplace_back(worker);
+        i++;
     }
+    worker();
+    for (auto& thread : threads) 
+        thread.join();
 }
 
-void mergeSortedParts(std::vector<StringWithLCP>& strings_array,
-                     int left_start,
-                     int middle_pos,
-                     int right_end) {
-    const int left_size = middle_pos - left_start + 1;
-    const int right_size = right_end - middle_pos;
-    
-    std::vector<StringWithLCP> left_part(left_size);
-    std::vector<StringWithLCP> right_part(right_size);
-    
-    copyStringRange(strings_array, left_part, left_start, middle_pos);
-    copyStringRange(strings_array, right_part, middle_pos + 1, right_end);
+// Stable LCP merge sort. Each thread first sorts one chunk; the chunks are
+// then merged pairwise, and every pairwise merge is cut into pieces of
+// roughly n / thread_count outputs by co-ranking so that all threads stay
+// busy even in the last rounds. Data moves between `strings` and a single
+// buffer of the same size.
+void parallelMergeSort(std::vector<StringWithLCP>& strings, int thread_count) {
+    const size_t string_count = strings.size();
+    std::vector<StringWithLCP> buffer(string_count);
+    if (thread_count <= 1 || string_count < parallel_merge_cutoff) {
+        performMergeSort(strings.data(), buffer.data(), string_count, false);
+        return;
+    }
     
-    int left_idx = 0;
-    int right_idx = 0;
-    int current_pos = left_start;
+    std::vector<size_t> run_start;
+    std::vector<std::function<void()>> tasks;
+    int chunk = 0;
+    while (chunk <= thread_count) {
+        run_start.push_back(string_count * chunk / thread_count);
+        chunk++;
+    }
+    chunk = 0;
+    while (chunk < thread_count) {
+        StringWithLCP* source = strings.data() + run_start[chunk];
+        StringWithLCP* target = buffer.data() + run_start[chunk];
+        size_t size = run_start[chunk + 1] - run_start[chunk];
+        tasks.push_back([source, target, size] { performMergeSort(source, target, size, false); });
+        chunk++;
+    }
+    runTasks(tasks, thread_count);
     
-    while (left_idx < left_size && right_idx < right_size) {
-        if (left_part[left_idx].second > right_part[right_idx].second) {
-            strings_array[current_pos] = left_part[left_idx];
-            left_idx++;
-        } 
-        else if (left_part[left_idx].second < right_part[right_idx].second) {
-            strings_array[current_pos] = right_part[right_idx];
-            right_idx++;
-        } 
-        else {
-            auto [comparison_result, new_lcp] = 
-                compareStringsByLCP(left_part[left_idx].first, 
-                                  right_part[right_idx].first, 
-                                  left_part[left_idx].second);
-            
-            if (comparison_result == -1) {
-                strings_array[current_pos] = left_part[left_idx];
-                left_idx++;
-                if (right_idx < right_size) 
-                    right_part[right_idx].second = new_lcp;
-            } 
-            else {
-                strings_array[current_pos] = right_part[right_idx];
-                right_idx++;
-                if (left_idx < left_size) 
-                    left_part[left_idx].second = new_lcp;
+    StringWithLCP* source = strings.data();
+    StringWithLCP* target = buffer.data();
+    while (run_start.size() > 2) {
+        tasks.clear();
+        std::vector<size_t> merged_start;
+        size_t run = 0;
+        while (run + 1 < run_start.size()) {
+            const size_t left = run_start[run];
+            const size_t middle = run_start[run + 1];
+            const size_t right = run + 2 < run_start.size() ? run_start[run + 2] : middle;
+            const size_t total = right - left;
+            const size_t parts = std::max<size_t>(1, (total * thread_count + string_count - 1) / string_count);
+            size_t part = 0;
+            while (part < parts) {
+                const size_t begin = total * part / parts;
+                const size_t end = total * (part + 1) / parts;
+                tasks.push_back([=] {
+                    mergeSegment(source + left, middle - left, source + middle, right - middle,
+                                 target + left, begin, end);
+                });
+                part++;
             }
+            merged_start.push_back(left);
+            run += 2;
         }
-        current_pos++;
+        merged_start.push_back(string_count);
+        runTasks(tasks, thread_count);
+        run_start.swap(merged_start);
+        std::swap(source, target);
     }
     
-    while (left_idx < left_size) {
-        strings_array[current_pos] = left_part[left_idx];
-        left_idx++;
-        current_pos++;
+    if (source != strings.data()) 
+        strings.swap(buffer);
+}
+
+// Sorted order together with what the merges already know about it:
+// permutation[k] is the input position of the k-th smallest string, lcp[k]
+// its LCP with the (k-1)-th (lcp[0] = 0), and distinguishing_prefix the
+// total number of bytes needed to tell every string from its neighbours.
+struct SortedOutput {
+    std::vector<size_t> permutation;
+    std::vector<size_t> lcp;
+    size_t distinguishing_prefix = 0;
+};
+
+SortedOutput sortWithLCP(const std::vector<std::string_view>& strings, int thread_count) {
+    std::vector<StringWithLCP> sorted(strings.size());
+    size_t idx = 0;
+    while (idx < strings.size()) {
+        sorted[idx] = {strings[idx], 0, idx};
+        idx++;
     }
+    parallelMergeSort(sorted, thread_count);
     
-    while (right_idx < right_size) {
-        strings_array[current_pos] = right_part[right_idx];
-        right_idx++;
-        current_pos++;
+    SortedOutput result;
+    result.permutation.resize(sorted.size());
+    result.lcp.resize(sorted.size());
+    idx = 0;
+    while (idx < sorted.size()) {
+        result.permutation[idx] = sorted[idx].index;
+        result.lcp[idx] = sorted[idx].lcp;
+        size_t next_lcp = idx + 1 < sorted.size() ? sorted[idx + 1].lcp : 0;
+        result.distinguishing_prefix += 
+            std::min(sorted[idx].str.size(), std::max(sorted[idx].lcp, next_lcp) + 1);
+        idx++;
     }
+    return result;
 }
 
-void performMergeSort(std::vector<StringWithLCP>& strings_array, 
-                     int left_bound, 
-                     int right_bound) {
-    if (left_bound >= right_bound) return;
-    
-    const int middle = left_bound + (right_bound - left_bound) / 2;
-    performMergeSort(strings_array, left_bound, middle);
-    performMergeSort(strings_array, middle + 1, right_bound);
-    mergeSortedParts(strings_array, left_bound, middle, right_bound);
+// Front-coded sorted stream: the magic, a varint restart interval, then one
+// record per string made of varint shared, varint suffix length and the
+// suffix bytes. `shared` is the LCP with the previous string, except at
+// every restart point where it is 0 and the whole string is stored, so a
+// reader can resynchronise at any restart.
+const char front_coding_magic[4] = {'F', 'C', 'S', '1'};
+const size_t front_coding_restart_interval = 16;
+
+void writeVarint(std::ostream& output, uint64_t value) {
+    char bytes[10];
+    int length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = static_cast<char>(value);
+    output.write(bytes, length);
 }
 
-std::vector<StringWithLCP> readInputStrings() {
-    int string_count;
-    std::cin >> string_count;
+bool readVarint(std::istream& input, uint64_t& value) {
+    value = 0;
+    int shift = 0;
+    while (shift < 64) {
+        int byte = input.get();
+        if (byte == EOF) 
+            return false;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) 
+            return true;
+        shift += 7;
+    }
+    return false;
+}
+
+class FrontCodedWriter {
+public:
+    explicit FrontCodedWriter(std::ostream& output, 
+                              size_t restart_interval = front_coding_restart_interval)
+        : output_(output), restart_interval_(restart_interval) {
+        output_.write(front_coding_magic, sizeof(front_coding_magic));
+        writeVarint(output_, restart_interval_);
+    }
+
+    // lcp is the LCP of str with the string added before it.
+    void add(std::string_view str, size_t lcp) {
+        const size_t shared = count_ % restart_interval_ == 0 ? 0 : lcp;
+        writeVarint(output_, shared);
+        writeVarint(output_, str.size() - shared);
+        output_.write(str.data() + shared, str.size() - shared);
+        count_++;
+    }
+
+private:
+    std::ostream& output_;
+    size_t restart_interval_;
+    size_t count_ = 0;
+};
+
+// Streams a front-coded file back. Between restarts the stored `shared`
+// is the LCP itself; at a restart it is recomputed against the previous
+// string, so the merge sees exact LCPs for the whole stream. The stream may
+// only end between two records; a truncated or inconsistent record stops
+// it and sets failed().
+class FrontCodedSource : public SortedSource {
+public:
+    explicit FrontCodedSource(const std::string& path) : input_(path, std::ios::binary) {
+        std::error_code error;
+        file_size_ = std::filesystem::file_size(path, error);
+        char magic[sizeof(front_coding_magic)];
+        uint64_t restart_interval;
+        failed_ = error || !input_.read(magic, sizeof(magic)) || 
+                  !std::equal(magic, magic + sizeof(magic), front_coding_magic) ||
+                  !readVarint(input_, restart_interval) || restart_interval == 0;
+    }
+
+    bool next() override {
+        if (failed_ || input_.peek() == EOF) {
+            failed_ = failed_ || input_.bad();
+            return false;
+        }
+        uint64_t shared;
+        uint64_t suffix_length;
+        if (!readVarint(input_, shared) || !readVarint(input_, suffix_length) ||
+            shared > current_.size() || suffix_length > file_size_) {
+            failed_ = true;
+            return false;
+        }
+        suffix_.resize(suffix_length);
+        if (!input_.read(suffix_.data(), suffix_length)) {
+            failed_ = true;
+            return false;
+        }
+        
+        if (shared == 0 && !first_) {
+            lcp_ = compareStringsByLCP(suffix_, current_, 0).second;
+            current_.swap(suffix_);
+        } else {
+            lcp_ = shared;
+            current_.resize(shared);
+            current_ += suffix_;
+        }
+        first_ = false;
+        return true;
+    }
+
+    std::string_view current() const override {
+        return current_;
+    }
+
+    size_t currentLcp() const override {
+        return lcp_;
+    }
+
+    // The file is not front-coded, could not be read, or ended inside a
+    // record.
+    bool failed() const override {
+        return failed_;
+    }
+
+private:
+    std::ifstream input_;
+    uintmax_t file_size_ = 0;
+    std::string current_;
+    std::string suffix_;
+    size_t lcp_ = 0;
+    bool failed_ = false;
+    bool first_ = true;
+};
+
+bool isFrontCoded(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    char magic[sizeof(front_coding_magic)];
+    return input.read(magic, sizeof(magic)) && 
+           std::equal(magic, magic + sizeof(magic), front_coding_magic);
+}
+
+// Merges the sorted files, plain or front-coded, to standard output.
+// Returns false, with a message on stderr, if a file cannot be read or a
+// front-coded one is corrupt or truncated.
+bool mergeSortedFiles(const std::vector<std::string>& paths, bool front_coded) {
+    std::vector<std::unique_ptr<SortedSource>> sources;
+    std::vector<const SortedSource*> readers;
+    std::vector<bool> is_front_coded;
+    for (const auto& path : paths) {
+        is_front_coded.push_back(isFrontCoded(path));
+        if (is_front_coded.back()) 
+            sources.push_back(std::make_unique<FrontCodedSource>(path));
+        else 
+            sources.push_back(std::make_unique<FileSource>(path));
+        readers.push_back(sources.back().get());
+    }
     
-    if (string_count == 0) 
-        return {};
+    LcpLoserTree tree(std::move(sources));
+    if (front_coded) {
+        FrontCodedWriter writer(std::cout);
+        while (!tree.empty()) {
+            writer.add(tree.top(), tree.topLcp());
+            tree.pop();
+        }
+    } else {
+        while (!tree.empty()) {
+            std::cout << tree.top() << '\n';
+            tree.pop();
+        }
+    }
     
-    std::vector<StringWithLCP> input_strings(string_count);
-    int idx = 0;
-    while (idx < string_count) {
-        std::cin >> input_strings[idx].first;
-        input_strings[idx].second = 0;
-        idx++;
+    bool ok = true;
+    size_t i = 0;
+    while (i < paths.size()) {
+        if (readers[i]->failed()) {
+            std::cerr << "cannot read " << paths[i] 
+                      << (is_front_coded[i] ? ": corrupt or truncated front-coded file\n" : "\n");
+            ok = false;
+        }
+        i++;
     }
-    return input_strings;
+    return ok;
 }
 
-void printSortedStrings(const std::vector<StringWithLCP>& sorted_strings) {
-    int idx = 0;
+void printSortedStrings(const std::vector<StringWithLCP>& sorted_strings, bool front_coded) {
+    size_t idx = 0;
+    if (front_coded) {
+        FrontCodedWriter writer(std::cout);
+        while (idx < sorted_strings.size()) {
+            writer.add(sorted_strings[idx].str, sorted_strings[idx].lcp);
+            idx++;
+        }
+        return;
+    }
     while (idx < sorted_strings.size()) {
-        std::cout << sorted_strings[idx].first << '\n';
+        std::cout << sorted_strings[idx].str << '\n';
         idx++;
     }
 }
 
-int main() {
+void markPhase(PhaseLog* stats, const char* phase) {
+    if (stats != nullptr) 
+        stats->mark(phase);
+}
+
+// Sorts standard input to standard output, marking the phases in `stats`
+// if there is one.
+void sortInput(int thread_count, bool with_lcp, bool front_coded, PhaseLog* stats) {
+    StringPool pool = readInputStrings();
+    std::vector<std::string_view> views = pool.views();
+    markPhase(stats, "parse");
+    if (views.empty()) 
+        return;
+    
+    if (with_lcp) {
+        // One line per string: input position, LCP with the previous line, string.
+        SortedOutput sorted = sortWithLCP(views, thread_count);
+        markPhase(stats, "sort");
+        size_t idx = 0;
+        while (idx < views.size()) {
+            std::cout << sorted.permutation[idx] << '\t' << sorted.lcp[idx] << '\t' 
+                      << views[sorted.permutation[idx]] << '\n';
+            idx++;
+        }
+        std::cout.flush();
+        markPhase(stats, "output");
+        std::cerr << "distinguishing prefix: " << sorted.distinguishing_prefix << " bytes\n";
+        return;
+    }
+    
+    std::vector<StringWithLCP> strings_to_sort(views.size());
+    size_t idx = 0;
+    while (idx < views.size()) {
+        strings_to_sort[idx] = {views[idx], 0, idx};
+        idx++;
+    }
+    parallelMergeSort(strings_to_sort, thread_count);
+    markPhase(stats, "sort");
+    printSortedStrings(strings_to_sort, front_coded);
+    std::cout.flush();
+    markPhase(stats, "output");
+}
+
+int main(int argc, char* argv[]) {
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
     
-    std::vector<StringWithLCP> strings_to_sort = readInputStrings();
+    int thread_count = 1;
+    bool with_lcp = false;
+    bool front_coded = false;
+    bool merge = false;
+    bool print_stats = false;
+    std::vector<std::string> merge_paths;
+    int arg = 1;
+    while (arg < argc) {
+        std::string flag = argv[arg];
+        if (flag == "--merge") {
+            merge = true;
+        } else if (flag == "--threads" && arg + 1 < argc) {
+            thread_count = std::max(1, std::atoi(argv[++arg]));
+        } else if (flag == "--lcp") {
+            with_lcp = true;
+        } else if (flag == "--front-coded") {
+            front_coded = true;
+        } else if (flag == "--stats") {
+            print_stats = true;
+        } else if (merge && flag.rfind("--", 0) != 0) {
+            merge_paths.push_back(flag);
+        } else {
+            std::cerr << "usage: " << argv[0] 
+                      << " [--threads N] [--lcp] [--front-coded] [--stats] [--merge FILE...]\n";
+            return 1;
+        }
+        arg++;
+    }
+    
+    // --stats: the phases of the run go to stderr as CSV.
+    std::unique_ptr<PhaseLog> stats;
+    if (print_stats) 
+        stats = std::make_unique<PhaseLog>();
     
-    if (!strings_to_sort.empty()) {
-        performMergeSort(strings_to_sort, 0, strings_to_sort.size() - 1);
-        printSortedStrings(strings_to_sort);
+    int status = 0;
+    if (merge) {
+        status = mergeSortedFiles(merge_paths, front_coded) ? 0 : 1;
+        std::cout.flush();
+        markPhase(stats.get(), "merge");
+    } else {
+        sortInput(thread_count, with_lcp, front_coded, stats.get());
     }
     
-    return 0;
+    if (stats != nullptr) 
+        stats->report();
+    return status;
 }
\ No newline at end of file
@@ -1,108 +1,80 @@
 #include <iostream>
-#include <vector>
+#include <memory>
 #include <string>
-#include <random>
+#include <algorithm>
+#include <cstdlib>
 
-using StringVector = std::vector<std::string>;
+#define STRINGSORT_COUNT_ALLOCATIONS 1
+#include "stringsort/instrumentation.hpp"
+#include "stringsort/io.hpp"
+#include "stringsort/multikey_quicksort.hpp"
 
-void swapStrings(std::string& a, std::string& b) {
-    std::swap(a, b);
-}
+using stringsort::PhaseLog;
+using stringsort::StringPool;
+using stringsort::StringVector;
 
-void moveShortStringsToFront(StringVector& strings, int start, int end, int depth) {
-    int insertion_pos = start;
-    int current = start;
-    
-    while (current <= end) {
-        if (strings[current].length() == static_cast<size_t>(depth)) {
-            swapStrings(strings[insertion_pos], strings[current]);
-            insertion_pos++;
-        }
-        current++;
-    }
+void markPhase(PhaseLog* stats, const char* phase) {
+    if (stats != nullptr) stats->mark(phase);
 }
 
-void partitionByPivot(StringVector& strings, int left, int right, int depth, 
-                     int& lower_bound, int& upper_bound) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(left, right);
-    
-    int pivot_index = dist(gen);
-    swapStrings(strings[left], strings[pivot_index]);
-    char pivot_char = strings[left][depth];
-    
-    lower_bound = left;
-    upper_bound = right;
-    int current = left + 1;
-    
-    while (current <= upper_bound) {
-        char current_char = strings[current][depth];
-        
-        if (current_char < pivot_char) {
-            swapStrings(strings[lower_bound], strings[current]);
-            lower_bound++;
-            current++;
-        } else if (current_char > pivot_char) {
-            swapStrings(strings[current], strings[upper_bound]);
-            upper_bound--;
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    // --top K prints the K smallest strings in order, --select K prints the
+    // K-th smallest (1-based). --stats prints the phases of the run to
+    // stderr as CSV.
+    int top = -1;
+    int select = -1;
+    bool print_stats = false;
+    int arg = 1;
+    while (arg < argc) {
+        std::string name = argv[arg];
+        if (name == "--top" && arg + 1 < argc && top < 0 && select < 0) {
+            top = std::max(0, std::atoi(argv[++arg]));
+        } else if (name == "--select" && arg + 1 < argc && top < 0 && select < 0) {
+            select = std::max(0, std::atoi(argv[++arg]));
+        } else if (name == "--stats") {
+            print_stats = true;
         } else {
-            current++;
+            std::cerr << "usage: " << argv[0] << " [--top K | --select K] [--stats]\n";
+            return 1;
         }
+        arg++;
     }
-}
 
-void ternaryQuickSort(StringVector& strings, int start, int end, int depth) {
-    if (start >= end) return;
-    
-    moveShortStringsToFront(strings, start, end, depth);
-    
-    int first_long = start;
-    while (first_long <= end && strings[first_long].length() == static_cast<size_t>(depth)) {
-        first_long++;
-    }
-    
-    if (first_long > end) return;
-    
-    int lower, upper;
-    partitionByPivot(strings, first_long, end, depth, lower, upper);
-    
-    ternaryQuickSort(strings, first_long, lower - 1, depth);
-    ternaryQuickSort(strings, lower, upper, depth + 1);
-    ternaryQuickSort(strings, upper + 1, end, depth);
-}
+    std::unique_ptr<PhaseLog> stats;
+    if (print_stats) stats = std::make_unique<PhaseLog>();
 
-StringVector readInputStrings() {
-    int count;
-    std::cin >> count;
-    
-    StringVector strings(count);
-    int i = 0;
-    while (i < count) {
-        std::cin >> strings[i];
-        i++;
-    }
-    return strings;
-}
+    StringPool pool = stringsort::readInputStrings();
+    StringVector strings = pool.views();
+    markPhase(stats.get(), "parse");
 
-void printSortedStrings(const StringVector& strings) {
-    int i = 0;
-    while (i < strings.size()) {
-        std::cout << strings[i] << '\n';
-        i++;
+    if (select >= 0 && (select < 1 || select > static_cast<int>(strings.size()))) {
+        std::cerr << "--select: K must be between 1 and " << strings.size() << "\n";
+        return 1;
     }
-}
 
-int main() {
-    std::ios_base::sync_with_stdio(false);
-    std::cin.tie(nullptr);
-    
-    StringVector strings = readInputStrings();
-    
     if (!strings.empty()) {
-        ternaryQuickSort(strings, 0, strings.size() - 1, 0);
-        printSortedStrings(strings);
+        if (select >= 0) {
+            stringsort::multikeyQuickSelect(strings.begin(), strings.begin() + select - 1, strings.end());
+            markPhase(stats.get(), "select");
+            std::cout << strings[select - 1] << '\n';
+        } else if (top >= 0) {
+            auto middle = strings.begin() + std::min<size_t>(top, strings.size());
+            stringsort::partialMultikeyQuickSort(strings.begin(), middle, strings.end());
+            strings.erase(middle, strings.end());
+            markPhase(stats.get(), "sort");
+            stringsort::printSortedStrings(strings);
+        } else {
+            stringsort::multikeyQuickSort(strings.begin(), strings.end());
+            markPhase(stats.get(), "sort");
+            stringsort::printSortedStrings(strings);
+        }
+        std::cout.flush();
+        markPhase(stats.get(), "output");
     }
-    
+
+    if (stats != nullptr) stats->report();
     return 0;
-}
\ No newline at end of file
+}
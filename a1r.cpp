@@ -1,125 +1,95 @@
 #include <iostream>
-#include <vector>
+#include <memory>
 #include <string>
 
-using StringVector = std::vector<std::string>;
+#define STRINGSORT_COUNT_ALLOCATIONS 1
+#include "stringsort/alphabet_radix.hpp"
+#include "stringsort/instrumentation.hpp"
+#include "stringsort/io.hpp"
+#include "stringsort/msd_radix.hpp"
 
-void moveStringsWithCurrentLengthToFront(StringVector& strings, int start, int end, int current_depth) {
-    int insert_position = start;
-    int current = start;
-    
-    while (current <= end) {
-        if (strings[current].length() == static_cast<size_t>(current_depth)) {
-            std::swap(strings[insert_position], strings[current]);
-            insert_position++;
-        }
-        current++;
-    }
-}
-
-void countCharacterFrequencies(const StringVector& strings, int start, int end, int depth, std::vector<int>& count) {
-    int current = start;
-    while (current <= end) {
-        unsigned char current_char = strings[current][depth];
-        count[current_char + 1]++;
-        current++;
-    }
-}
-
-void computePrefixSums(std::vector<int>& count) {
-    int i = 1;
-    while (i < 256) {
-        count[i] += count[i - 1];
-        i++;
-    }
-}
+using stringsort::MappedFile;
+using stringsort::PhaseLog;
+using stringsort::StringPool;
+using stringsort::StringVector;
 
-void distributeStringsToBuckets(const StringVector& strings, int start, int end, int depth, 
-                               std::vector<int>& count, StringVector& temp_buffer) {
-    std::vector<int> position(count.begin(), count.begin() + 256);
-    
-    int current = start;
-    while (current <= end) {
-        unsigned char current_char = strings[current][depth];
-        temp_buffer[position[current_char]] = strings[current];
-        position[current_char]++;
-        current++;
-    }
+// Sorts with the radix kernel for the named alphabet; false if the name is
+// not one of them.
+bool sortWithAlphabet(StringVector& strings, const std::string& alphabet) {
+    if (alphabet == "byte")
+        stringsort::msdRadixSort(strings.begin(), strings.end());
+    else if (alphabet == "dna")
+        stringsort::alphabetRadixSort<stringsort::DnaAlphabet>(strings.begin(), strings.end());
+    else if (alphabet == "digits")
+        stringsort::alphabetRadixSort<stringsort::DecimalAlphabet>(strings.begin(), strings.end());
+    else if (alphabet == "base64")
+        stringsort::alphabetRadixSort<stringsort::Base64Alphabet>(strings.begin(), strings.end());
+    else if (alphabet == "printable")
+        stringsort::alphabetRadixSort<stringsort::PrintableAlphabet>(strings.begin(), strings.end());
+    else
+        return false;
+    return true;
 }
 
-void copyBackFromBuffer(StringVector& strings, int start, const StringVector& temp_buffer, int length) {
-    int i = 0;
-    while (i < length) {
-        strings[start + i] = temp_buffer[i];
-        i++;
-    }
+void markPhase(PhaseLog* stats, const char* phase) {
+    if (stats != nullptr) stats->mark(phase);
 }
 
-void msdRadixSortRecursive(StringVector& strings, int start, int end, int depth) {
-    if (start >= end) return;
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(nullptr);
 
-    moveStringsWithCurrentLengthToFront(strings, start, end, depth);
-    
-    int first_long_string = start;
-    while (first_long_string <= end && strings[first_long_string].length() == static_cast<size_t>(depth)) {
-        first_long_string++;
+    // --alphabet dna|digits|base64|printable switches to the radix kernel
+    // for that alphabet; input with other bytes is still sorted correctly.
+    // --stats prints the phases of the run to stderr as CSV.
+    std::string input_path;
+    std::string alphabet = "byte";
+    bool print_stats = false;
+    int arg = 1;
+    while (arg < argc) {
+        std::string name = argv[arg];
+        if (name == "--input" && arg + 1 < argc) {
+            input_path = argv[++arg];
+        } else if (name == "--alphabet" && arg + 1 < argc) {
+            alphabet = argv[++arg];
+        } else if (name == "--stats") {
+            print_stats = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--input FILE] [--alphabet dna|digits|base64|printable] [--stats]\n";
+            return 1;
+        }
+        arg++;
     }
-    
-    if (first_long_string > end) return;
 
-    const int bucket_count = 256;
-    std::vector<int> count(bucket_count + 1, 0);
-    const int segment_length = end - first_long_string + 1;
-    StringVector temp_buffer(segment_length);
+    std::unique_ptr<PhaseLog> stats;
+    if (print_stats) stats = std::make_unique<PhaseLog>();
 
-    countCharacterFrequencies(strings, first_long_string, end, depth, count);
-    computePrefixSums(count);
-    distributeStringsToBuckets(strings, first_long_string, end, depth, count, temp_buffer);
-    copyBackFromBuffer(strings, first_long_string, temp_buffer, segment_length);
-
-    int char_value = 0;
-    while (char_value < bucket_count) {
-        int segment_start = first_long_string + count[char_value];
-        int segment_end = first_long_string + count[char_value + 1] - 1;
-        msdRadixSortRecursive(strings, segment_start, segment_end, depth + 1);
-        char_value++;
-    }
-}
-
-StringVector readInputStrings() {
-    int string_count;
-    std::cin >> string_count;
-    
+    StringPool pool;
     StringVector strings;
-    if (string_count > 0) {
-        strings.resize(string_count);
-        int i = 0;
-        while (i < string_count) {
-            std::cin >> strings[i];
-            i++;
+    std::unique_ptr<MappedFile> mapped_input;
+    if (!input_path.empty()) {
+        mapped_input = std::make_unique<MappedFile>(input_path);
+        if (!mapped_input->isOpen()) {
+            std::cerr << "cannot open " << input_path << "\n";
+            return 1;
         }
+        strings = stringsort::splitInputLines(mapped_input->contents());
+    } else {
+        pool = stringsort::readInputStrings();
+        strings = pool.views();
     }
-    return strings;
-}
+    markPhase(stats.get(), "parse");
 
-void printSortedStrings(const StringVector& strings) {
-    int i = 0;
-    while (i < strings.size()) {
-        std::cout << strings[i] << '\n';
-        i++;
-    }
-}
-
-int main() {
-    std::ios_base::sync_with_stdio(false);
-    std::cin.tie(nullptr);
-    
-    StringVector strings = readInputStrings();
-    
     if (!strings.empty()) {
-        msdRadixSortRecursive(strings, 0, strings.size() - 1, 0);
-        printSortedStrings(strings);
+        if (!sortWithAlphabet(strings, alphabet)) {
+            std::cerr << "unknown alphabet " << alphabet << "\n";
+            return 1;
+        }
+        markPhase(stats.get(), "sort");
+        stringsort::printSortedStrings(strings);
+        markPhase(stats.get(), "output");
     }
-    
+
+    if (stats != nullptr) stats->report();
     return 0;
-}
\ No newline at end of file
+}
@@ -1,186 +1,1102 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <random>
+#include <string_view>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+#include "stringsort/alphabet_radix.hpp"
+#include "stringsort/cached_radix.hpp"
+#define STRINGSORT_COUNT_ALLOCATIONS 1
+#include "stringsort/instrumentation.hpp"
+#include "stringsort/io.hpp"
+#include "stringsort/lcp_merge_sort.hpp"
+#include "stringsort/loser_tree.hpp"
+#include "stringsort/msd_radix.hpp"
+#include "stringsort/mismatch.hpp"
+#include "stringsort/multikey_quicksort.hpp"
+#include "stringsort/parallel_radix.hpp"
+#include "stringsort/sample_sort.hpp"
+#include "stringsort/sorted_string_store.hpp"
+
+using stringsort::FileSource;
+using stringsort::LcpLoserTree;
+using stringsort::MappedFile;
+using stringsort::PhaseLog;
+using stringsort::SortedSource;
+using stringsort::SortedStringStore;
+using stringsort::StringPool;
+using stringsort::StringVector;
+using stringsort::StringWithLCP;
+using stringsort::charAtDepth;
+using stringsort::compareStringsByLCP;
+using stringsort::mergeSortedParts;
+using stringsort::output_buffer_size;
+using stringsort::printSortedStrings;
+using stringsort::readInputStrings;
+using stringsort::splitInputLines;
+using stringsort::splitLines;
 
-using StringVector = std::vector<std::string>;
 const int alphabet = 256;
-const int switch_to_quick = 74;
 
-void swapStrings(std::string& a, std::string& b) {
-    std::swap(a, b);
+// Below this size the stable sort finishes a range by insertion sort and the
+// adaptive engine stops sampling and hands the range to multikey quicksort.
+const int small_range = 74;
+
+const int adaptive_sample_size = 64;
+const int presorted_descent_ratio = 32;
+const double radix_entropy_threshold = 1.0;
+
+// A line of the input together with the key it is sorted by. Both are views
+// into the input, so the sorts below move these small handles and never the
+// payload. The sorting templates reach the key through keyOf().
+struct Record {
+    std::string_view key;
+    std::string_view line;
+};
+
+std::string_view keyOf(std::string_view str) {
+    return str;
+}
+
+std::string_view keyOf(const Record& record) {
+    return record.key;
+}
+
+// The projection through which the library's templates reach the key.
+const auto key_projection = [](const auto& item) { return keyOf(item); };
+
+// Leaves only the smallest `count` strings, in order. Partitions that
+// start at or after count are dropped unsorted by the library's partial
+// multikey quicksort, which keeps its pending ranges on a bounded stack.
+template <typename Item>
+void topKSort(std::vector<Item>& strings, int count) {
+    const size_t kept = std::min<size_t>(count, strings.size());
+    stringsort::partialMultikeyQuickSort(strings.begin(), strings.begin() + kept, strings.end(), 
+                                         key_projection);
+    strings.resize(kept);
 }
 
-void moveStringsWithCurrentDepthToFront(StringVector& strings, int start, int end, int depth) {
-    int insert_pos = start;
-    int current = start;
+// A range of stableMsdRadixSort whose keys share their first depth bytes.
+struct StableSortTask {
+    int start;
+    int end;
+    int depth;
+};
+
+// Stable MSD radix sort. Each pass distributes [start, end] into `buffer`
+// and copies it back, which keeps equal bytes in input order; bucket 0 holds
+// the keys that end at `depth`, so they stay in front and in order as well.
+// Small ranges go to the (stable) insertion sort. When `duplicate` is given,
+// duplicate[i] is set for every key equal to the one before it: keys in
+// bucket 0 are equal by construction, and the insertion sort only needs to
+// look at neighbours.
+// A range whose keys all share the byte at depth is not moved, only the
+// depth advances. Otherwise the largest bucket is sorted next in the same
+// loop and the others wait on an explicit stack, so neither long shared
+// prefixes nor deep keys grow the call stack.
+template <typename Item>
+void stableMsdRadixSort(std::vector<Item>& strings, std::vector<Item>& buffer, 
+                        std::vector<char>* duplicate, int start, int end, int depth) {
+    std::vector<StableSortTask> pending;
+    std::array<int, alphabet + 2> count;
+    std::array<int, alphabet + 1> next_free;
+    pending.push_back({start, end, depth});
     
-    while (current <= end) {
-        if (strings[current].length() == static_cast<size_t>(depth)) {
-            swapStrings(strings[insert_pos], strings[current]);
-            insert_pos++;
+    while (!pending.empty()) {
+        start = pending.back().start;
+        end = pending.back().end;
+        depth = pending.back().depth;
+        pending.pop_back();
+        
+        while (start < end) {
+            if ((end - start + 1) < small_range) {
+                stringsort::insertionSortFrom(strings.begin() + start, strings.begin() + end + 1, depth, 
+                                              key_projection);
+                if (duplicate != nullptr) {
+                    int i = start + 1;
+                    while (i <= end) {
+                        (*duplicate)[i] = keyOf(strings[i]).substr(depth) == keyOf(strings[i - 1]).substr(depth);
+                        i++;
+                    }
+                }
+                break;
+            }
+            
+            count.fill(0);
+            int current = start;
+            while (current <= end) {
+                count[charAtDepth(keyOf(strings[current]), depth) + 2]++;
+                current++;
+            }
+            
+            int largest = 1;
+            int bucket = 2;
+            while (bucket <= alphabet) {
+                if (count[bucket + 1] > count[largest + 1]) 
+                    largest = bucket;
+                bucket++;
+            }
+            if (count[largest + 1] == end - start + 1) {
+                depth++;
+                continue;
+            }
+            
+            bucket = 1;
+            while (bucket <= alphabet + 1) {
+                count[bucket] += count[bucket - 1];
+                bucket++;
+            }
+            
+            std::copy(count.begin(), count.end() - 1, next_free.begin());
+            current = start;
+            while (current <= end) {
+                buffer[start + next_free[charAtDepth(keyOf(strings[current]), depth) + 1]++] = strings[current];
+                current++;
+            }
+            std::copy(buffer.begin() + start, buffer.begin() + end + 1, strings.begin() + start);
+            
+            if (duplicate != nullptr) {
+                int i = start + 1;
+                while (i < start + count[1]) {
+                    (*duplicate)[i] = true;
+                    i++;
+                }
+            }
+            
+            bucket = 1;
+            while (bucket <= alphabet) {
+                if (bucket != largest && count[bucket + 1] - count[bucket] > 1) 
+                    pending.push_back({start + count[bucket], start + count[bucket + 1] - 1, depth + 1});
+                bucket++;
+            }
+            const int largest_start = start + count[largest];
+            end = start + count[largest + 1] - 1;
+            start = largest_start;
+            depth++;
         }
-        current++;
     }
 }
 
-void partitionByPivot(StringVector& strings, int left, int right, int depth, 
-                     int& lower_bound, int& upper_bound) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(left, right);
-    
-    int pivot_index = dist(gen);
-    swapStrings(strings[left], strings[pivot_index]);
-    char pivot_char = strings[left][depth];
-    
-    lower_bound = left;
-    upper_bound = right;
-    int current = left + 1;
+template <typename Item>
+void stableSort(std::vector<Item>& strings) {
+    std::vector<Item> buffer(strings.size());
+    stableMsdRadixSort(strings, buffer, static_cast<std::vector<char>*>(nullptr), 
+                       0, static_cast<int>(strings.size()) - 1, 0);
+}
+
+// Sorts stably and keeps only the first of every group of equal keys.
+// Returns the size of each group; the groups are recognised while sorting,
+// so the compaction below compares no strings.
+template <typename Item>
+std::vector<size_t> sortUnique(std::vector<Item>& strings) {
+    std::vector<Item> buffer(strings.size());
+    std::vector<char> duplicate(strings.size(), false);
+    stableMsdRadixSort(strings, buffer, &duplicate, 0, static_cast<int>(strings.size()) - 1, 0);
     
-    while (current <= upper_bound) {
-        char current_char = strings[current][depth];
-        
-        if (current_char < pivot_char) {
-            swapStrings(strings[lower_bound], strings[current]);
-            lower_bound++;
-            current++;
-        } else if (current_char > pivot_char) {
-            swapStrings(strings[current], strings[upper_bound]);
-            upper_bound--;
+    std::vector<size_t> counts;
+    size_t kept = 0;
+    size_t i = 0;
+    while (i < strings.size()) {
+        if (duplicate[i]) {
+            counts.back()++;
         } else {
-            current++;
+            strings[kept++] = strings[i];
+            counts.push_back(1);
         }
+        i++;
     }
+    strings.resize(kept);
+    return counts;
 }
 
-void ternaryQuickSort(StringVector& strings, int start, int end, int depth) {
-    if (start >= end) return;
-    
-    moveStringsWithCurrentDepthToFront(strings, start, end, depth);
+// Burstsort: the strings are first inserted into a byte-indexed trie whose
+// leaves are buckets of handles. A bucket that grows past burst_threshold
+// handles (128 KiB, about the size of L2) bursts into a new trie node one
+// byte deeper. Insertion touches only the trie top and the bucket tails;
+// every bucket is then sorted with multikey quicksort while it still fits
+// into the cache, instead of sweeping the whole input once per level.
+// A bucket whose strings would mostly stay together one byte deeper, as
+// with a long shared prefix, is not burst; its limit doubles instead, and
+// if it never splits it is sorted by radixQuickSortFrom as a whole.
+const size_t burst_threshold = 8192;
+
+struct BurstNode {
+    StringVector ended;
+    std::array<StringVector, alphabet> buckets;
+    std::array<std::unique_ptr<BurstNode>, alphabet> children;
+    // How many times the limit of each bucket has been doubled.
+    std::array<unsigned char, alphabet> postponed{};
+};
+
+// Whether bursting the bucket would split it: no part one byte deeper,
+// counting the strings that end there, may keep more than half of it.
+bool burstSplits(const StringVector& bucket, int depth) {
+    std::array<size_t, alphabet + 1> count{};
+    for (std::string_view str : bucket) 
+        count[charAtDepth(str, depth) + 1]++;
+    return *std::max_element(count.begin(), count.end()) <= bucket.size() / 2;
+}
+
+void burstInsert(BurstNode* node, std::string_view str, int depth) {
+    while (true) {
+        if (str.length() == static_cast<size_t>(depth)) {
+            node->ended.push_back(str);
+            return;
+        }
+        unsigned char current_char = str[depth];
+        if (node->children[current_char] != nullptr) {
+            node = node->children[current_char].get();
+            depth++;
+            continue;
+        }
+        
+        StringVector& bucket = node->buckets[current_char];
+        bucket.push_back(str);
+        if (bucket.size() > (burst_threshold << node->postponed[current_char])) {
+            if (!burstSplits(bucket, depth + 1)) {
+                node->postponed[current_char]++;
+                return;
+            }
+            auto child = std::make_unique<BurstNode>();
+            StringVector burst_strings;
+            burst_strings.swap(bucket);
+            for (std::string_view burst_string : burst_strings) 
+                burstInsert(child.get(), burst_string, depth + 1);
+            node->children[current_char] = std::move(child);
+        }
+        return;
+    }
+}
+
+// In-order walk: strings ending at this node, then for every byte either
+// the child trie or the sorted bucket.
+void burstCollect(BurstNode* node, int depth, StringVector& output, size_t& position) {
+    for (std::string_view str : node->ended) 
+        output[position++] = str;
     
-    int first_long_string = start;
-    while (first_long_string <= end && 
-           strings[first_long_string].length() == static_cast<size_t>(depth)) {
-        first_long_string++;
+    int char_value = 0;
+    while (char_value < alphabet) {
+        if (node->children[char_value] != nullptr) {
+            burstCollect(node->children[char_value].get(), depth + 1, output, position);
+        } else {
+            StringVector& bucket = node->buckets[char_value];
+            if (bucket.size() > burst_threshold) 
+                stringsort::radixQuickSortFrom(bucket.begin(), bucket.end(), depth + 1);
+            else 
+                stringsort::multikeyQuickSortFrom(bucket.begin(), bucket.end(), depth + 1);
+            std::copy(bucket.begin(), bucket.end(), output.begin() + position);
+            position += bucket.size();
+            StringVector().swap(bucket);
+        }
+        char_value++;
     }
+}
+
+void burstSort(StringVector& strings) {
+    BurstNode root;
+    for (std::string_view str : strings) 
+        burstInsert(&root, str, 0);
     
-    if (first_long_string > end) return;
+    size_t position = 0;
+    burstCollect(&root, 0, strings, position);
+}
+
+// Statistics of a segment taken from a fixed-stride sample, used by the
+// adaptive engine to pick an algorithm before touching every string.
+struct SegmentStats {
+    int sampled_pairs = 0;
+    int descending_pairs = 0;
+    int ascending_pairs = 0;
+    size_t common_prefix = 0;
+    double entropy = 0.0;
+};
+
+SegmentStats sampleSegment(const StringVector& strings, int start, int end, int depth) {
+    SegmentStats stats;
+    const int segment_length = end - start + 1;
+    const int sample_size = std::min(adaptive_sample_size, segment_length - 1);
+    std::array<int, alphabet + 1> histogram{};
     
-    int lower, upper;
-    partitionByPivot(strings, first_long_string, end, depth, lower, upper);
+    std::string_view reference = strings[start];
+    stats.common_prefix = reference.length() - depth;
+    int k = 0;
+    while (k < sample_size) {
+        int i = start + static_cast<int>(static_cast<long long>(segment_length - 1) * k / sample_size);
+        auto [order, lcp] = compareStringsByLCP(strings[i], strings[i + 1], depth);
+        stats.sampled_pairs++;
+        if (order > 0) stats.descending_pairs++;
+        if (order < 0) stats.ascending_pairs++;
+        
+        stats.common_prefix = std::min(stats.common_prefix,
+            compareStringsByLCP(strings[i], reference, depth).second - depth);
+        histogram[charAtDepth(strings[i], depth) + 1]++;
+        k++;
+    }
     
-    ternaryQuickSort(strings, first_long_string, lower - 1, depth);
-    ternaryQuickSort(strings, lower, upper, depth + 1);
-    ternaryQuickSort(strings, upper + 1, end, depth);
+    for (int count : histogram) {
+        if (count == 0) continue;
+        double p = static_cast<double>(count) / sample_size;
+        stats.entropy -= p * std::log2(p);
+    }
+    return stats;
 }
 
-void countCharacterFrequencies(const StringVector& strings, int start, int end, 
-                             int depth, std::vector<int>& count) {
-    int current = start;
-    while (current <= end) {
-        unsigned char current_char = strings[current][depth];
-        count[current_char + 1]++;
-        current++;
+// Returns 1 if the segment is in ascending order, -1 if in non-increasing
+// order and 0 otherwise; stops at the first pair that rules both out.
+int detectSortedOrder(const StringVector& strings, int start, int end, int depth) {
+    bool ascending = true;
+    bool descending = true;
+    int i = start;
+    while (i < end && (ascending || descending)) {
+        int order = compareStringsByLCP(strings[i], strings[i + 1], depth).first;
+        if (order > 0) ascending = false;
+        if (order < 0) descending = false;
+        i++;
     }
+    if (ascending) return 1;
+    return descending ? -1 : 0;
 }
 
-void computePrefixSums(std::vector<int>& count) {
-    int i = 1;
-    while (i <= alphabet) {
-        count[i] += count[i - 1];
+// Length of the prefix after depth that every string in the segment shares
+// with strings[start], given that the sample suggests at most `bound`.
+size_t segmentCommonPrefix(const StringVector& strings, int start, int end, int depth, size_t bound) {
+    std::string_view reference = strings[start];
+    int i = start + 1;
+    while (i <= end && bound > 0) {
+        std::string_view current = strings[i].substr(0, depth + bound);
+        bound = compareStringsByLCP(current, reference.substr(0, depth + bound), depth).second - depth;
         i++;
     }
+    return bound;
 }
 
-void distributeStrings(const StringVector& strings, int start, int end, int depth,
-                     std::vector<int>& count, StringVector& temp_buffer) {
-    std::vector<int> pos(count.begin(), count.begin() + alphabet);
+// Natural merge sort for nearly sorted segments: one pass finds the
+// ascending runs and the LCP of every string with its predecessor, then
+// runs are merged pairwise with mergeSortedParts between two buffers.
+void lcpMergeNaturalRuns(StringVector& strings, int start, int end, int depth) {
+    const int segment_length = end - start + 1;
+    std::vector<StringWithLCP> buffers[2] = {
+        std::vector<StringWithLCP>(segment_length),
+        std::vector<StringWithLCP>(segment_length)
+    };
     
-    int current = start;
-    while (current <= end) {
-        unsigned char current_char = strings[current][depth];
-        temp_buffer[pos[current_char]] = strings[current];
-        pos[current_char]++;
-        current++;
+    std::vector<int> run_start = {0};
+    buffers[0][0] = {strings[start], static_cast<size_t>(depth), 0};
+    int i = 1;
+    while (i < segment_length) {
+        buffers[0][i] = {strings[start + i], static_cast<size_t>(depth), static_cast<size_t>(i)};
+        auto [order, lcp] = compareStringsByLCP(buffers[0][i - 1].str, buffers[0][i].str, depth);
+        if (order > 0) {
+            run_start.push_back(i);
+        } else {
+            buffers[0][i].lcp = lcp;
+        }
+        i++;
+    }
+    run_start.push_back(segment_length);
+    
+    int source = 0;
+    while (run_start.size() > 2) {
+        const int target = 1 - source;
+        std::vector<int> merged_start;
+        size_t run = 0;
+        while (run + 1 < run_start.size()) {
+            const int left = run_start[run];
+            const int middle = run_start[run + 1];
+            const int right = run + 2 < run_start.size() ? run_start[run + 2] : middle;
+            mergeSortedParts(&buffers[source][left], middle - left, depth,
+                             &buffers[source][middle], right - middle, depth,
+                             &buffers[target][left]);
+            merged_start.push_back(left);
+            run += 2;
+        }
+        merged_start.push_back(segment_length);
+        run_start.swap(merged_start);
+        source = target;
+    }
+    
+    i = 0;
+    while (i < segment_length) {
+        strings[start + i] = buffers[source][i].str;
+        i++;
     }
 }
 
-void msdRadixSort(StringVector& strings, int start, int end, int depth) {
-    if (start >= end) return;
-    
-    if ((end - start + 1) < switch_to_quick) {
-        ternaryQuickSort(strings, start, end, depth);
+// Chooses an algorithm for every subproblem from sampled statistics:
+// presorted input is skipped, reversed or merged by natural runs, a prefix
+// shared by the whole segment is skipped in one step, segments whose next
+// character is spread over many values get a radix pass, and skewed or
+// small ones go to multikey quicksort.
+void adaptiveSort(StringVector& strings, int start, int end, int depth) {
+    while (end - start + 1 >= small_range) {
+        SegmentStats stats = sampleSegment(strings, start, end, depth);
+        
+        if (stats.descending_pairs == 0 || stats.ascending_pairs == 0) {
+            int order = detectSortedOrder(strings, start, end, depth);
+            if (order > 0) return;
+            if (order < 0) {
+                std::reverse(strings.begin() + start, strings.begin() + end + 1);
+                return;
+            }
+        }
+        
+        if (stats.descending_pairs * presorted_descent_ratio < stats.sampled_pairs) {
+            lcpMergeNaturalRuns(strings, start, end, depth);
+            return;
+        }
+        
+        if (stats.common_prefix > 0) {
+            size_t shared = segmentCommonPrefix(strings, start, end, depth, stats.common_prefix);
+            if (shared > 0) {
+                depth += shared;
+                continue;
+            }
+        }
+        
+        if (stats.entropy < radix_entropy_threshold) 
+            break;
+        
+        const auto bounds = stringsort::distributeByByte(strings.begin() + start, strings.begin() + end + 1, depth);
+        int bucket = 1;
+        while (bucket <= alphabet) {
+            int segment_start = start + bounds[bucket];
+            int segment_end = start + bounds[bucket + 1] - 1;
+            if (segment_start < segment_end) 
+                adaptiveSort(strings, segment_start, segment_end, depth + 1);
+            bucket++;
+        }
         return;
     }
     
-    moveStringsWithCurrentDepthToFront(strings, start, end, depth);
+    stringsort::multikeyQuickSortFrom(strings.begin() + start, strings.begin() + end + 1, depth);
+}
+
+// Where the key of a record sits: the field-th field (1-based) between
+// delimiters, or, when field is 0, `length` bytes starting at `offset`.
+// A missing field or a range past the end gives an empty or shorter key.
+struct KeySpec {
+    int field = 0;
+    char delimiter = '\t';
+    size_t offset = 0;
+    size_t length = std::string_view::npos;
+};
+
+std::string_view extractKey(std::string_view line, const KeySpec& spec) {
+    if (spec.field == 0) 
+        return line.substr(std::min(spec.offset, line.size()), spec.length);
     
-    int first_long_string = start;
-    while (first_long_string <= end && 
-           strings[first_long_string].length() == static_cast<size_t>(depth)) {
-        first_long_string++;
+    size_t field_start = 0;
+    int field = 1;
+    while (field < spec.field) {
+        size_t delimiter = line.find(spec.delimiter, field_start);
+        if (delimiter == std::string_view::npos) 
+            return std::string_view();
+        field_start = delimiter + 1;
+        field++;
+    }
+    size_t field_end = line.find(spec.delimiter, field_start);
+    return line.substr(field_start, field_end == std::string_view::npos ? 
+                                    std::string_view::npos : field_end - field_start);
+}
+
+std::vector<Record> makeRecords(const StringVector& lines, const KeySpec& spec) {
+    std::vector<Record> records(lines.size());
+    size_t i = 0;
+    while (i < lines.size()) {
+        records[i] = {extractKey(lines[i], spec), lines[i]};
+        i++;
     }
+    return records;
+}
+
+// How keys are ordered. The engines only compare bytes, so any other order
+// is produced by turning every key once into a binary sort key whose byte
+// order is the wanted order:
+//  - fold_case maps ASCII A-Z to a-z;
+//  - numeric replaces every run of digits by '0', four big-endian bytes with
+//    the number of significant digits, and those digits, so "file2" sorts
+//    before "file10" and a number still sorts where a digit would.
+// UTF-8 needs no transform: for valid UTF-8, byte order is code-point order.
+struct Collation {
+    bool fold_case = false;
+    bool numeric = false;
     
-    if (first_long_string > end) return;
+    bool isByteOrder() const {
+        return !fold_case && !numeric;
+    }
+};
+
+void encodeSortKey(std::string_view str, const Collation& collation, std::string& key) {
+    key.clear();
+    size_t i = 0;
+    while (i < str.size()) {
+        char current_char = str[i];
+        if (collation.numeric && current_char >= '0' && current_char <= '9') {
+            size_t run_end = i;
+            while (run_end < str.size() && str[run_end] >= '0' && str[run_end] <= '9') 
+                run_end++;
+            while (i + 1 < run_end && str[i] == '0') 
+                i++;
+            if (str[i] == '0') 
+                i++;
+            const uint32_t digit_count = run_end - i;
+            key.push_back('0');
+            key.push_back(static_cast<char>(digit_count >> 24));
+            key.push_back(static_cast<char>(digit_count >> 16));
+            key.push_back(static_cast<char>(digit_count >> 8));
+            key.push_back(static_cast<char>(digit_count));
+            key.append(str.substr(i, run_end - i));
+            i = run_end;
+            continue;
+        }
+        if (collation.fold_case && current_char >= 'A' && current_char <= 'Z') 
+            current_char = current_char - 'A' + 'a';
+        key.push_back(current_char);
+        i++;
+    }
+}
+
+// Replaces every record key by its binary sort key; the encoded keys live
+// in key_pool, the lines are left untouched.
+void applyCollation(std::vector<Record>& records, const Collation& collation, StringPool& key_pool) {
+    key_pool.reserve(records.size());
+    std::string key;
+    for (const Record& record : records) {
+        encodeSortKey(record.key, collation, key);
+        key_pool.append(key);
+    }
+    StringVector keys = key_pool.views();
+    size_t i = 0;
+    while (i < records.size()) {
+        records[i].key = keys[i];
+        i++;
+    }
+}
+
+// Same as printSortedStrings, with the size of its group of equal keys in
+// front of every line: "count<TAB>line".
+void printCountedStrings(const StringVector& strings, const std::vector<size_t>& counts) {
+    std::vector<char> buffer;
+    buffer.reserve(output_buffer_size);
+    size_t i = 0;
+    while (i < strings.size()) {
+        std::string_view str = strings[i];
+        if (buffer.size() + str.size() + 22 > output_buffer_size && !buffer.empty()) {
+            std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+            buffer.clear();
+        }
+        char digits[20];
+        char* digits_end = std::to_chars(digits, digits + sizeof(digits), counts[i]).ptr;
+        buffer.insert(buffer.end(), digits, digits_end);
+        buffer.push_back('\t');
+        buffer.insert(buffer.end(), str.begin(), str.end());
+        buffer.push_back('\n');
+        i++;
+    }
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+    std::fflush(stdout);
+}
+
+struct SortOptions {
+    int thread_count = 1;
+    bool cached = false;
+    bool adaptive = false;
+    bool burst = false;
+    // --alphabet: radix kernel specialised for a small alphabet, "byte" for none.
+    std::string alphabet = "byte";
+    // --sample: string sample sort, for inputs too large for radix passes to stay in cache.
+    bool sample = false;
+    bool external = false;
+    size_t memory_limit = size_t(1) << 30;
+    std::filesystem::path temp_dir = std::filesystem::temp_directory_path();
+    std::string input_path;
+    bool records = false;
+    KeySpec key;
+    bool stable = false;
+    bool unique = false;
+    // Keep only the first `top` lines of the output; -1 keeps all.
+    int top = -1;
+    // Feed the input to a SortedStringStore in batches of this many strings.
+    size_t incremental_batch = 0;
+    Collation collation;
+    // --stats: the phases of the run are marked in `stats` and printed.
+    bool print_stats = false;
+    PhaseLog* stats = nullptr;
+};
+
+void markPhase(const SortOptions& options, const std::string& phase) {
+    if (options.stats != nullptr) 
+        options.stats->mark(phase);
+}
+
+bool isKnownAlphabet(const std::string& alphabet) {
+    return alphabet == "byte" || alphabet == "dna" || alphabet == "digits" || 
+           alphabet == "base64" || alphabet == "printable";
+}
+
+void sortWithAlphabet(StringVector& strings, const std::string& alphabet) {
+    if (alphabet == "dna") 
+        stringsort::alphabetRadixSort<stringsort::DnaAlphabet>(strings.begin(), strings.end());
+    else if (alphabet == "digits") 
+        stringsort::alphabetRadixSort<stringsort::DecimalAlphabet>(strings.begin(), strings.end());
+    else if (alphabet == "base64") 
+        stringsort::alphabetRadixSort<stringsort::Base64Alphabet>(strings.begin(), strings.end());
+    else 
+        stringsort::alphabetRadixSort<stringsort::PrintableAlphabet>(strings.begin(), strings.end());
+}
+
+void sortStrings(StringVector& strings, const SortOptions& options) {
+    if (strings.empty()) return;
+    
+    if (options.stable) {
+        stableSort(strings);
+    } else if (options.adaptive) {
+        adaptiveSort(strings, 0, strings.size() - 1, 0);
+    } else if (options.burst) {
+        burstSort(strings);
+    } else if (options.cached) {
+        stringsort::cachedRadixSort(strings.begin(), strings.end());
+    } else if (options.alphabet != "byte") {
+        sortWithAlphabet(strings, options.alphabet);
+    } else if (options.sample) {
+        stringsort::stringSampleSort(strings.begin(), strings.end());
+    } else {
+        stringsort::parallelRadixQuickSort(strings.begin(), strings.end(), options.thread_count);
+    }
+}
+
+const int max_merge_fan_in = 256;
+
+std::filesystem::path makeRunPath(const std::filesystem::path& temp_dir) {
+    static int run_counter = 0;
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    return temp_dir / ("a1rq-run-" + std::to_string(stamp) + "-" + 
+                       std::to_string(run_counter++) + ".tmp");
+}
+
+// printSortedStrings for any stream: lines are collected into blocks of
+// output_buffer_size and every block is written with a single call.
+class LineWriter {
+public:
+    explicit LineWriter(std::ostream& output) : output_(output) {
+        buffer_.reserve(output_buffer_size);
+    }
+
+    ~LineWriter() {
+        flush();
+    }
+
+    LineWriter(const LineWriter&) = delete;
+    LineWriter& operator=(const LineWriter&) = delete;
+
+    void write(std::string_view line) {
+        if (buffer_.size() + line.size() + 1 > output_buffer_size && !buffer_.empty()) 
+            flush();
+        buffer_.insert(buffer_.end(), line.begin(), line.end());
+        buffer_.push_back('\n');
+    }
+
+    void flush() {
+        output_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+private:
+    std::ostream& output_;
+    std::vector<char> buffer_;
+};
+
+void writeStrings(const StringVector& strings, std::ostream& output) {
+    LineWriter writer(output);
+    for (std::string_view str : strings) 
+        writer.write(str);
+}
+
+// Writes one sorted run; false if the file cannot be created or written.
+bool writeRun(const StringVector& strings, const std::filesystem::path& path) {
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open()) return false;
+    writeStrings(strings, output);
+    output.close();
+    return !output.fail();
+}
+
+// Merges the runs into output; false if a run cannot be read back or the
+// output cannot be written.
+bool mergeRuns(const std::vector<std::filesystem::path>& runs, std::ostream& output) {
+    std::vector<std::unique_ptr<SortedSource>> sources;
+    std::vector<const FileSource*> files;
+    for (const auto& path : runs) {
+        auto source = std::make_unique<FileSource>(path);
+        files.push_back(source.get());
+        sources.push_back(std::move(source));
+    }
     
-    std::vector<int> count(alphabet + 1, 0);
-    const int segment_length = end - first_long_string + 1;
-    StringVector temp_buffer(segment_length);
+    LcpLoserTree tree(std::move(sources));
+    {
+        LineWriter writer(output);
+        while (!tree.empty()) {
+            writer.write(tree.top());
+            tree.pop();
+        }
+    }
+    for (const FileSource* file : files) {
+        if (file->failed()) return false;
+    }
+    return !output.fail();
+}
+
+// The spilled runs of one external sort. The files still listed are
+// deleted when the sort returns, whether it succeeded or not.
+struct RunFiles {
+    std::vector<std::filesystem::path> paths;
+
+    RunFiles() = default;
+    RunFiles(const RunFiles&) = delete;
+    RunFiles& operator=(const RunFiles&) = delete;
+
+    ~RunFiles() {
+        for (const auto& path : paths) {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        }
+    }
+};
+
+// Reads the input in runs that fit into options.memory_limit, sorts each run
+// with the RadixQuick path and spills it to a temporary file, then merges
+// the runs. Input that fits into a single run never touches the disk. Lines
+// are read whole, as splitInputLines does for the in-memory path. Returns
+// false, with a message on stderr, if a run or the output cannot be written
+// or a run cannot be read back.
+bool externalSort(std::istream& input, std::ostream& output, const SortOptions& options) {
+    std::string line;
+    long long string_count = 0;
+    if (std::getline(input, line)) 
+        std::from_chars(line.data(), line.data() + line.size(), string_count);
     
-    countCharacterFrequencies(strings, first_long_string, end, depth, count);
-    computePrefixSums(count);
-    distributeStrings(strings, first_long_string, end, depth, count, temp_buffer);
+    StringPool pool;
+    RunFiles runs;
+    auto spill = [&runs, &options](const StringVector& strings) {
+        runs.paths.push_back(makeRunPath(options.temp_dir));
+        if (writeRun(strings, runs.paths.back())) return true;
+        std::cerr << "cannot write run " << runs.paths.back().string() << "\n";
+        return false;
+    };
     
-    int i = 0;
-    while (i < segment_length) {
-        strings[first_long_string + i] = temp_buffer[i];
+    long long i = 0;
+    while (i < string_count && std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') 
+            line.pop_back();
+        pool.append(line);
         i++;
+        if (pool.memoryUsage() >= options.memory_limit && i < string_count) {
+            StringVector strings = pool.views();
+            sortStrings(strings, options);
+            if (!spill(strings)) return false;
+            pool.clear();
+        }
     }
     
-    int char_value = 0;
-    while (char_value < alphabet) {
-        int segment_start = first_long_string + count[char_value];
-        int segment_end = first_long_string + count[char_value + 1] - 1;
-        msdRadixSort(strings, segment_start, segment_end, depth + 1);
-        char_value++;
+    // The last run, which may be short when the input ends early.
+    StringVector strings = pool.views();
+    sortStrings(strings, options);
+    if (runs.paths.empty()) {
+        markPhase(options, "sort");
+        writeStrings(strings, output);
+        markPhase(options, "output");
+        if (!output.flush()) {
+            std::cerr << "cannot write the output\n";
+            return false;
+        }
+        return true;
+    }
+    if (!strings.empty() && !spill(strings)) return false;
+    
+    markPhase(options, "runs");
+    while (runs.paths.size() > static_cast<size_t>(max_merge_fan_in)) {
+        std::vector<std::filesystem::path> group(runs.paths.begin(), runs.paths.begin() + max_merge_fan_in);
+        const std::filesystem::path merged_path = makeRunPath(options.temp_dir);
+        runs.paths.push_back(merged_path);
+        std::ofstream merged(merged_path, std::ios::binary);
+        if (!merged.is_open() || !mergeRuns(group, merged) || !merged.flush()) {
+            std::cerr << "cannot merge runs into " << merged_path.string() << "\n";
+            return false;
+        }
+        merged.close();
+        if (merged.fail()) {
+            std::cerr << "cannot merge runs into " << merged_path.string() << "\n";
+            return false;
+        }
+        runs.paths.erase(runs.paths.begin(), runs.paths.begin() + max_merge_fan_in);
+        for (const auto& path : group) {
+            std::filesystem::remove(path);
+        }
+    }
+    
+    if (!mergeRuns(runs.paths, output) || !output.flush()) {
+        std::cerr << "cannot merge the runs into the output\n";
+        return false;
     }
+    markPhase(options, "merge");
+    return true;
 }
 
-StringVector readInputStrings() {
-    int string_count;
-    std::cin >> string_count;
+void sortAndPrintRecords(std::vector<Record>& records, const SortOptions& options) {
+    std::vector<size_t> counts;
+    if (options.unique) {
+        counts = sortUnique(records);
+    } else if (options.stable) {
+        stableSort(records);
+    } else if (options.top >= 0) {
+        topKSort(records, options.top);
+    } else {
+        stringsort::parallelRadixQuickSort(records.begin(), records.end(), options.thread_count, key_projection);
+    }
+    if (options.top >= 0 && records.size() > static_cast<size_t>(options.top)) {
+        records.resize(options.top);
+        counts.resize(std::min(counts.size(), records.size()));
+    }
+    markPhase(options, "sort");
     
-    StringVector strings;
-    if (string_count > 0) {
-        strings.resize(string_count);
-        int i = 0;
-        while (i < string_count) {
-            std::cin >> strings[i];
-            i++;
-        }
+    StringVector lines(records.size());
+    size_t i = 0;
+    while (i < records.size()) {
+        lines[i] = records[i].line;
+        i++;
     }
-    return strings;
+    if (options.unique) 
+        printCountedStrings(lines, counts);
+    else 
+        printSortedStrings(lines);
+    markPhase(options, "output");
 }
 
-void printSortedStrings(const StringVector& strings) {
-    int i = 0;
-    while (i < strings.size()) {
-        std::cout << strings[i] << '\n';
+bool parseOptions(int argc, char* argv[], SortOptions& options) {
+    int i = 1;
+    while (i < argc) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.thread_count = std::atoi(argv[++i]);
+            if (options.thread_count <= 0) 
+                options.thread_count = std::max(1u, std::thread::hardware_concurrency());
+        } else if (arg == "--cached") {
+            options.cached = true;
+        } else if (arg == "--adaptive") {
+            options.adaptive = true;
+        } else if (arg == "--burst") {
+            options.burst = true;
+        } else if (arg == "--sample") {
+            options.sample = true;
+        } else if (arg == "--alphabet" && i + 1 < argc) {
+            options.alphabet = argv[++i];
+            if (!isKnownAlphabet(options.alphabet)) 
+                return false;
+        } else if (arg == "--external") {
+            options.external = true;
+        } else if (arg == "--memory-limit" && i + 1 < argc) {
+            options.memory_limit = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "--input" && i + 1 < argc) {
+            options.input_path = argv[++i];
+        } else if (arg == "--temp-dir" && i + 1 < argc) {
+            options.temp_dir = argv[++i];
+        } else if (arg == "--top" && i + 1 < argc) {
+            options.top = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--incremental" && i + 1 < argc) {
+            options.incremental_batch = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "--collation" && i + 1 < argc) {
+            std::string_view list = argv[++i];
+            while (!list.empty()) {
+                std::string_view name = list.substr(0, list.find(','));
+                list.remove_prefix(std::min(list.size(), name.size() + 1));
+                if (name == "ci") 
+                    options.collation.fold_case = true;
+                else if (name == "numeric") 
+                    options.collation.numeric = true;
+                else if (name != "byte" && name != "utf8") 
+                    return false;
+            }
+        } else if (arg == "--stats") {
+            options.print_stats = true;
+        } else if (arg == "--stable") {
+            options.stable = true;
+        } else if (arg == "--unique") {
+            options.unique = true;
+        } else if (arg == "--key-field" && i + 1 < argc) {
+            options.records = true;
+            options.key.field = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--delimiter" && i + 1 < argc) {
+            options.key.delimiter = argv[++i][0];
+        } else if (arg == "--key-bytes" && i + 1 < argc) {
+            // OFFSET or OFFSET:LENGTH
+            std::string_view range = argv[++i];
+            size_t colon = range.find(':');
+            options.records = true;
+            options.key.field = 0;
+            std::from_chars(range.data(), range.data() + std::min(colon, range.size()), 
+                            options.key.offset);
+            if (colon != std::string_view::npos) 
+                std::from_chars(range.data() + colon + 1, range.data() + range.size(), 
+                                options.key.length);
+        } else {
+            return false;
+        }
         i++;
     }
+    const bool in_memory_only = options.records || options.stable || options.unique || 
+                                options.top >= 0 || options.incremental_batch > 0 ||
+                                !options.collation.isByteOrder();
+    return !(in_memory_only && options.external) && 
+           !(options.incremental_batch > 0 && 
+             (options.records || options.unique || !options.collation.isByteOrder()));
 }
 
-int main() {
-    std::ios_base::sync_with_stdio(false);
-    std::cin.tie(nullptr);
+// Everything after option parsing. Returns the exit status.
+int runSort(const SortOptions& options) {
+    if (options.external) {
+        if (options.input_path.empty()) 
+            return externalSort(std::cin, std::cout, options) ? 0 : 1;
+        std::ifstream input(options.input_path, std::ios::binary);
+        if (!input.is_open()) {
+            std::cerr << "cannot open " << options.input_path << "\n";
+            return 1;
+        }
+        return externalSort(input, std::cout, options) ? 0 : 1;
+    }
     
-    StringVector strings = readInputStrings();
+    if (options.records) {
+        // Whole lines, no leading count. The lines and the keys stay views
+        // into the mapped file (or into one copy of stdin).
+        std::string stdin_data;
+        std::unique_ptr<MappedFile> mapped_input;
+        std::string_view data;
+        if (options.input_path.empty()) {
+            stdin_data.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+            data = stdin_data;
+        } else {
+            mapped_input = std::make_unique<MappedFile>(options.input_path);
+            if (!mapped_input->isOpen()) {
+                std::cerr << "cannot open " << options.input_path << "\n";
+                return 1;
+            }
+            data = mapped_input->contents();
+        }
+        
+        std::vector<Record> records = makeRecords(splitLines(data), options.key);
+        if (records.empty()) return 0;
+        StringPool key_pool;
+        if (!options.collation.isByteOrder()) 
+            applyCollation(records, options.collation, key_pool);
+        markPhase(options, "parse");
+        sortAndPrintRecords(records, options);
+        return 0;
+    }
+    
+    StringPool pool;
+    StringVector strings;
+    std::unique_ptr<MappedFile> mapped_input;
+    if (options.input_path.empty()) {
+        pool = readInputStrings();
+        strings = pool.views();
+    } else {
+        mapped_input = std::make_unique<MappedFile>(options.input_path);
+        if (!mapped_input->isOpen()) {
+            std::cerr << "cannot open " << options.input_path << "\n";
+            return 1;
+        }
+        strings = splitInputLines(mapped_input->contents());
+    }
     
-    if (!strings.empty()) {
-        msdRadixSort(strings, 0, strings.size() - 1, 0);
+    markPhase(options, "parse");
+    if (strings.empty()) return 0;
+    if (!options.collation.isByteOrder()) {
+        std::vector<Record> records(strings.size());
+        size_t i = 0;
+        while (i < strings.size()) {
+            records[i] = {strings[i], strings[i]};
+            i++;
+        }
+        StringPool key_pool;
+        applyCollation(records, options.collation, key_pool);
+        sortAndPrintRecords(records, options);
+    } else if (options.incremental_batch > 0) {
+        SortedStringStore store;
+        size_t batch_start = 0;
+        while (batch_start < strings.size()) {
+            size_t batch_end = std::min(strings.size(), batch_start + options.incremental_batch);
+            store.insert(StringVector(strings.begin() + batch_start, strings.begin() + batch_end));
+            batch_start = batch_end;
+        }
+        markPhase(options, "insert");
+        StringVector sorted;
+        sorted.reserve(store.size());
+        store.scanFrom("", [&sorted](std::string_view str) { sorted.push_back(str); });
+        if (options.top >= 0 && sorted.size() > static_cast<size_t>(options.top)) 
+            sorted.resize(options.top);
+        markPhase(options, "scan");
+        printSortedStrings(sorted);
+        markPhase(options, "output");
+    } else if (options.unique) {
+        std::vector<size_t> counts = sortUnique(strings);
+        if (options.top >= 0 && strings.size() > static_cast<size_t>(options.top)) {
+            strings.resize(options.top);
+            counts.resize(options.top);
+        }
+        markPhase(options, "sort");
+        printCountedStrings(strings, counts);
+        markPhase(options, "output");
+    } else if (options.top >= 0 && !options.stable) {
+        topKSort(strings, options.top);
+        markPhase(options, "sort");
         printSortedStrings(strings);
+        markPhase(options, "output");
+    } else {
+        sortStrings(strings, options);
+        if (options.top >= 0 && strings.size() > static_cast<size_t>(options.top)) 
+            strings.resize(options.top);
+        markPhase(options, "sort");
+        printSortedStrings(strings);
+        markPhase(options, "output");
     }
     
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    
+    SortOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [--input FILE] [--threads N] [--cached] [--adaptive] [--burst] [--sample] [--stats]"
+                  << " [--alphabet byte|dna|digits|base64|printable]"
+                  << " [--stable] [--unique] [--top K] [--incremental BATCH] [--external [--memory-limit BYTES] [--temp-dir DIR]]"
+                  << " [--collation byte|ci|numeric|utf8[,...]]"
+                  << " | [--input FILE] [--threads N] [--stable] [--unique] [--top K] [--collation LIST]"
+                  << " (--key-field N [--delimiter C] | --key-bytes OFFSET[:LENGTH])\n";
+        return 1;
+    }
+    
+    std::unique_ptr<PhaseLog> stats;
+    if (options.print_stats) {
+        stats = std::make_unique<PhaseLog>();
+        options.stats = stats.get();
+    }
+    
+    int status = runSort(options);
+    if (stats != nullptr) 
+        stats->report();
+    return status;
+}
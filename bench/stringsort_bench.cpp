@@ -0,0 +1,173 @@
+// Times the stringsort engines against std::sort on seeded synthetic data
+// and checks every result against std::sort's. Prints one CSV row per
+// engine, dataset and size:
+//
+//   engine,type,size,median_us,min_us
+//
+// Usage: stringsort_bench [--sizes N,N,...] [--runs R] [--seed S]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stringsort/stringsort.hpp"
+
+using StringVector = std::vector<std::string_view>;
+
+// A record sorted through a projection, the way a caller embeds the library.
+struct Row {
+    std::string_view key;
+    size_t id;
+};
+
+// The symbols a1.cpp's StringGenerator draws from.
+struct GeneratorAlphabet {
+    static constexpr std::string_view symbols =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789!@#%:;^&*()-";
+};
+
+// random, prefix (a shared 100-byte prefix) and sorted draw from the
+// generator alphabet; dna is reads over ACGT, digits numeric IDs.
+std::vector<std::string> generateStrings(const std::string& type, size_t count, uint32_t seed) {
+    std::seed_seq seq{seed, static_cast<uint32_t>(count)};
+    std::mt19937 gen(seq);
+    std::string_view characters = GeneratorAlphabet::symbols;
+    int min_length = 10;
+    int max_length = 200;
+    if (type == "dna") {
+        characters = stringsort::DnaAlphabet::symbols;
+        min_length = 50;
+        max_length = 150;
+    } else if (type == "digits") {
+        characters = stringsort::DecimalAlphabet::symbols;
+        min_length = 6;
+        max_length = 18;
+    }
+    std::uniform_int_distribution<int> length_dist(min_length, max_length);
+    std::uniform_int_distribution<size_t> char_dist(0, characters.size() - 1);
+    const std::string prefix = type == "prefix" ? std::string(100, 'p') : std::string();
+
+    std::vector<std::string> strings(count);
+    size_t i = 0;
+    while (i < count) {
+        std::string str = prefix;
+        int length = length_dist(gen);
+        while (static_cast<int>(str.size() - prefix.size()) < length) {
+            str.push_back(characters[char_dist(gen)]);
+        }
+        strings[i] = std::move(str);
+        i++;
+    }
+    if (type == "sorted")
+        std::sort(strings.begin(), strings.end());
+    return strings;
+}
+
+struct Engine {
+    std::string name;
+    std::function<void(StringVector&, const std::string& type)> run;
+};
+
+void sortByAlphabet(StringVector& strings, const std::string& type) {
+    if (type == "dna")
+        stringsort::alphabetRadixSort<stringsort::DnaAlphabet>(strings.begin(), strings.end());
+    else if (type == "digits")
+        stringsort::alphabetRadixSort<stringsort::DecimalAlphabet>(strings.begin(), strings.end());
+    else
+        stringsort::alphabetRadixSort<GeneratorAlphabet>(strings.begin(), strings.end());
+}
+
+std::vector<Engine> engines() {
+    return {
+        {"std::sort", [](StringVector& s, const std::string&) { std::sort(s.begin(), s.end()); }},
+        {"lcpMergeSort", [](StringVector& s, const std::string&) { stringsort::lcpMergeSort(s.begin(), s.end()); }},
+        {"multikeyQuickSort", [](StringVector& s, const std::string&) { stringsort::multikeyQuickSort(s.begin(), s.end()); }},
+        {"msdRadixSort", [](StringVector& s, const std::string&) { stringsort::msdRadixSort(s.begin(), s.end()); }},
+        {"radixQuickSort", [](StringVector& s, const std::string&) { stringsort::radixQuickSort(s.begin(), s.end()); }},
+        {"radixQuickSort(proj)", [](StringVector& s, const std::string&) {
+            std::vector<Row> rows(s.size());
+            size_t i = 0;
+            while (i < s.size()) {
+                rows[i] = {s[i], i};
+                i++;
+            }
+            stringsort::radixQuickSort(rows.begin(), rows.end(), &Row::key);
+            i = 0;
+            while (i < s.size()) {
+                s[i] = rows[i].key;
+                i++;
+            }
+        }},
+        {"alphabetRadixSort", sortByAlphabet},
+        {"stringSampleSort", [](StringVector& s, const std::string&) { stringsort::stringSampleSort(s.begin(), s.end()); }},
+    };
+}
+
+std::vector<size_t> parseSizes(const std::string& list) {
+    std::vector<size_t> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        sizes.push_back(std::strtoull(item.c_str(), nullptr, 10));
+    }
+    return sizes;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes = {10000, 100000, 1000000};
+    int runs = 5;
+    uint32_t seed = 42;
+    int i = 1;
+    while (i < argc) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes = parseSizes(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--sizes N,N,...] [--runs R] [--seed S]\n";
+            return 1;
+        }
+        i++;
+    }
+
+    std::cout << "engine,type,size,median_us,min_us\n";
+    for (const std::string type : {"random", "prefix", "sorted", "dna", "digits"}) {
+        for (size_t size : sizes) {
+            std::vector<std::string> data = generateStrings(type, size, seed);
+            StringVector expected(data.begin(), data.end());
+            std::sort(expected.begin(), expected.end());
+
+            for (const Engine& engine : engines()) {
+                std::vector<double> times;
+                int run = 0;
+                while (run < runs) {
+                    StringVector strings(data.begin(), data.end());
+                    auto start = std::chrono::steady_clock::now();
+                    engine.run(strings, type);
+                    auto stop = std::chrono::steady_clock::now();
+                    times.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+                    if (strings != expected) {
+                        std::cerr << engine.name << " sorted " << type << "/" << size << " wrongly\n";
+                        return 1;
+                    }
+                    run++;
+                }
+                std::sort(times.begin(), times.end());
+                std::cout << engine.name << ',' << type << ',' << size << ','
+                          << times[times.size() / 2] << ',' << times[0] << '\n';
+            }
+        }
+    }
+    return 0;
+}
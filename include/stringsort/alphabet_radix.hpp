@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/msd_radix.hpp"
+#include "stringsort/multikey_quicksort.hpp"
+
+namespace stringsort {
+
+// Alphabets for alphabetRadixSort. Any type with a `symbols` member listing
+// distinct bytes (in any order) works; keys are still ordered by byte value.
+struct DnaAlphabet {
+    static constexpr std::string_view symbols = "ACGT";
+};
+
+struct DecimalAlphabet {
+    static constexpr std::string_view symbols = "0123456789";
+};
+
+struct Base64Alphabet {
+    static constexpr std::string_view symbols =
+        "+/0123456789=ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+};
+
+struct PrintableAlphabet {
+    static constexpr std::string_view symbols =
+        " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+        "abcdefghijklmnopqrstuvwxyz{|}~";
+};
+
+// Every byte: alphabetRadixSort<ByteAlphabet> is radixQuickSort.
+struct ByteAlphabet {};
+
+namespace detail {
+
+// A packed digit should keep its histogram within the L1 cache.
+const int max_digit_buckets = 2048;
+const uint8_t not_in_alphabet = 0xff;
+
+// Digits over a small alphabet. Symbols get dense ranks 1..size in byte
+// order, with 0 for "the key has ended", and `width` consecutive positions
+// are packed into one digit of radix^width buckets: four DNA bases or three
+// decimal digits per pass instead of one byte. A digit whose last position
+// is 0 belongs to keys that end inside it, and such keys are all equal.
+template <typename Alphabet>
+struct PackedDigits {
+    static_assert(Alphabet::symbols.size() > 0 && Alphabet::symbols.size() < 255,
+                  "an alphabet needs between 1 and 254 symbols");
+
+    static constexpr int radix = static_cast<int>(Alphabet::symbols.size()) + 1;
+
+    static constexpr int width = [] {
+        int digits = 1;
+        int buckets = radix;
+        while (buckets * radix <= max_digit_buckets) {
+            buckets *= radix;
+            digits++;
+        }
+        return digits;
+    }();
+
+    static constexpr int bucket_count = [] {
+        int buckets = 1;
+        int i = 0;
+        while (i < width) {
+            buckets *= radix;
+            i++;
+        }
+        return buckets;
+    }();
+
+    static constexpr std::array<uint8_t, 256> rank = [] {
+        std::array<uint8_t, 256> table{};
+        table.fill(not_in_alphabet);
+        for (char symbol : Alphabet::symbols) {
+            int smaller = 0;
+            for (char other : Alphabet::symbols) {
+                if (static_cast<unsigned char>(other) < static_cast<unsigned char>(symbol))
+                    smaller++;
+            }
+            table[static_cast<unsigned char>(symbol)] = static_cast<uint8_t>(smaller + 1);
+        }
+        return table;
+    }();
+
+    // The packed digit at depth, or -1 if a byte there is not in the alphabet.
+    static int digitAt(std::string_view key, Index depth) {
+        int digit = 0;
+        int i = 0;
+        while (i < width) {
+            int symbol = 0;
+            if (static_cast<size_t>(depth + i) < key.size()) {
+                symbol = rank[static_cast<unsigned char>(key[depth + i])];
+                if (symbol == not_in_alphabet) return -1;
+            }
+            digit = digit * radix + symbol;
+            i++;
+        }
+        return digit;
+    }
+
+    static bool keysEndInside(int digit) {
+        return digit % radix == 0;
+    }
+};
+
+// Same American-flag scheme as msdRadixSort, one packed digit per pass. If
+// a key of the range has a byte outside the alphabet, the range is handed
+// to the byte-wise sort instead. As there, only the buckets other than the
+// largest recurse, and the largest is sorted by the next iteration.
+template <typename Alphabet, typename RandomIt, typename Proj>
+void alphabetRadixSort(RandomIt first, Index start, Index end, Index depth, Proj& proj) {
+    using Digits = PackedDigits<Alphabet>;
+    const Index quick_threshold = std::max<Index>(switch_to_quick, Digits::bucket_count / 8);
+    if ((end - start + 1) < quick_threshold) {
+        if (start < end) ternaryQuickSort(first, start, end, depth, end + 1, proj);
+        return;
+    }
+
+    std::vector<Index> count(Digits::bucket_count + 1);
+    std::vector<Index> next_free(Digits::bucket_count);
+    while (start < end) {
+        if ((end - start + 1) < quick_threshold) {
+            ternaryQuickSort(first, start, end, depth, end + 1, proj);
+            return;
+        }
+
+        std::fill(count.begin(), count.end(), 0);
+        Index current = start;
+        while (current <= end) {
+            int digit = Digits::digitAt(keyOf(proj, first[current]), depth);
+            if (digit < 0) {
+                msdRadixSort(first, start, end, depth, switch_to_quick, proj);
+                return;
+            }
+            count[digit + 1]++;
+            current++;
+        }
+
+        int largest = -1;
+        int bucket = 0;
+        while (bucket < Digits::bucket_count) {
+            if (!Digits::keysEndInside(bucket) && (largest < 0 || count[bucket + 1] > count[largest + 1]))
+                largest = bucket;
+            bucket++;
+        }
+
+        bucket = 1;
+        while (bucket <= Digits::bucket_count) {
+            count[bucket] += count[bucket - 1];
+            bucket++;
+        }
+
+        std::copy(count.begin(), count.end() - 1, next_free.begin());
+        bucket = 0;
+        while (bucket < Digits::bucket_count) {
+            while (next_free[bucket] < count[bucket + 1]) {
+                std::iter_value_t<RandomIt> item = std::move(first[start + next_free[bucket]]);
+                int digit = Digits::digitAt(keyOf(proj, item), depth);
+                while (digit != bucket) {
+                    using std::swap;
+                    swap(item, first[start + next_free[digit]]);
+                    next_free[digit]++;
+                    digit = Digits::digitAt(keyOf(proj, item), depth);
+                }
+                first[start + next_free[bucket]] = std::move(item);
+                next_free[bucket]++;
+            }
+            bucket++;
+        }
+
+        bucket = 0;
+        while (bucket < Digits::bucket_count) {
+            if (bucket != largest && !Digits::keysEndInside(bucket) && count[bucket + 1] - count[bucket] > 1) {
+                alphabetRadixSort<Alphabet>(first, start + count[bucket], start + count[bucket + 1] - 1,
+                                            depth + Digits::width, proj);
+            }
+            bucket++;
+        }
+
+        const Index base = start;
+        start = base + count[largest];
+        end = base + count[largest + 1] - 1;
+        depth += Digits::width;
+    }
+}
+
+}  // namespace detail
+
+// MSD radix sort specialised for keys over a small alphabet, chosen at
+// compile time: stringsort::alphabetRadixSort<stringsort::DnaAlphabet>(...).
+// Keys with other bytes are still sorted correctly, only without the gain.
+// Not stable.
+template <typename Alphabet, std::random_access_iterator RandomIt, typename Proj = std::identity>
+void alphabetRadixSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    if constexpr (std::is_same_v<Alphabet, ByteAlphabet>) {
+        radixQuickSort(first, last, proj);
+    } else {
+        detail::checkProjection<RandomIt, Proj>();
+        detail::alphabetRadixSort<Alphabet>(first, 0, (last - first) - 1, 0, proj);
+    }
+}
+
+}  // namespace stringsort
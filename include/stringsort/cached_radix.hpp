@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/msd_radix.hpp"
+
+namespace stringsort {
+namespace detail {
+
+// An element together with the eight bytes of its key from some depth on,
+// as packedWordAt reads them.
+template <typename Item>
+struct CachedKey {
+    uint64_t word;
+    Item item;
+};
+
+// A range waiting to be sorted by cachedRadixSort, whose words hold the key
+// bytes from cache_depth on.
+struct CachedSortTask {
+    Index start;
+    Index end;
+    Index depth;
+    Index cache_depth;
+};
+
+template <typename Item, typename Proj>
+void refillWords(std::vector<CachedKey<Item>>& items, Index start, Index end, Index depth, Proj& proj) {
+    while (start <= end) {
+        items[start].word = packedWordAt(keyOf(proj, items[start].item), depth);
+        start++;
+    }
+}
+
+// Three-way quicksort on the words, for ranges below switch_to_quick. The
+// keys equal to the pivot word move past the bytes they share. Only the two
+// smaller partitions recurse; the loop goes on with the largest.
+template <typename Item, typename Proj>
+void cachedQuickSort(std::vector<CachedKey<Item>>& items, Index start, Index end, Index depth,
+                     Index cache_depth, Proj& proj) {
+    auto item_proj = [&proj](CachedKey<Item>& key) { return keyOf(proj, key.item); };
+    while (start < end) {
+        if (cache_depth != depth) {
+            refillWords(items, start, end, depth, proj);
+            cache_depth = depth;
+        }
+
+        const Index first_long = moveStringsWithCurrentDepthToFront(items.begin(), start, end, depth, item_proj);
+        if (first_long >= end) return;
+
+        const uint64_t a = items[first_long].word;
+        const uint64_t b = items[first_long + (end - first_long) / 2].word;
+        const uint64_t c = items[end].word;
+        const uint64_t pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        Index lower = first_long;
+        Index upper = end;
+        Index current = first_long;
+        while (current <= upper) {
+            if (items[current].word < pivot) {
+                std::swap(items[lower], items[current]);
+                lower++;
+                current++;
+            } else if (items[current].word > pivot) {
+                std::swap(items[current], items[upper]);
+                upper--;
+            } else {
+                current++;
+            }
+        }
+
+        SortTask parts[3] = {
+            {first_long, lower - 1, depth},
+            {lower, upper, depth + sharedBytes(pivot)},
+            {upper + 1, end, depth}
+        };
+        std::sort(parts, parts + 3, [](const SortTask& x, const SortTask& y) {
+            return x.end - x.start < y.end - y.start;
+        });
+        cachedQuickSort(items, parts[0].start, parts[0].end, parts[0].depth, cache_depth, proj);
+        cachedQuickSort(items, parts[1].start, parts[1].end, parts[1].depth, cache_depth, proj);
+        start = parts[2].start;
+        end = parts[2].end;
+        depth = parts[2].depth;
+    }
+}
+
+// Radix passes that read their digits from the words, 16-bit digits on
+// ranges of at least wide_digit_threshold keys and 8-bit ones below, and
+// distribute through `buffer`. A range whose keys all share the digit is
+// found before the histogram is cleared and only advances the depth;
+// otherwise the largest bucket is sorted next in the same loop and the
+// others wait on an explicit stack, so the histogram is allocated once for
+// the whole sort.
+template <typename Item, typename Proj>
+void cachedRadixSort(std::vector<CachedKey<Item>>& items, std::vector<CachedKey<Item>>& buffer, Proj& proj) {
+    auto item_proj = [&proj](CachedKey<Item>& key) { return keyOf(proj, key.item); };
+    std::vector<Index> count((1 << 16) + 1);
+    std::vector<Index> next_free(1 << 16);
+    std::vector<CachedSortTask> pending = {{0, static_cast<Index>(items.size()) - 1, 0, 0}};
+
+    while (!pending.empty()) {
+        CachedSortTask task = pending.back();
+        pending.pop_back();
+
+        while (task.start < task.end) {
+            if ((task.end - task.start + 1) < switch_to_quick) {
+                cachedQuickSort(items, task.start, task.end, task.depth, task.cache_depth, proj);
+                break;
+            }
+
+            const Index start = moveStringsWithCurrentDepthToFront(items.begin(), task.start, task.end,
+                                                                   task.depth, item_proj);
+            const Index end = task.end;
+            if (start >= end) break;
+
+            const int digit_bytes = (end - start + 1) >= wide_digit_threshold ? 2 : 1;
+            if (task.depth + digit_bytes > task.cache_depth + 8) {
+                refillWords(items, start, end, task.depth, proj);
+                task.cache_depth = task.depth;
+            }
+
+            const int shift = 64 - 8 * (task.depth - task.cache_depth + digit_bytes);
+            const int bucket_count = 1 << (8 * digit_bytes);
+            const uint64_t digit_mask = bucket_count - 1;
+            const unsigned first_digit = (items[start].word >> shift) & digit_mask;
+            Index current = start + 1;
+            while (current <= end && ((items[current].word >> shift) & digit_mask) == first_digit) {
+                current++;
+            }
+            if (current > end) {
+                task.start = start;
+                task.depth += digitAdvance(digit_bytes, first_digit);
+                continue;
+            }
+
+            std::fill(count.begin(), count.begin() + bucket_count + 1, 0);
+            current = start;
+            while (current <= end) {
+                count[((items[current].word >> shift) & digit_mask) + 1]++;
+                current++;
+            }
+            const int largest = std::max_element(count.begin() + 1, count.begin() + bucket_count + 1) -
+                                (count.begin() + 1);
+
+            int digit = 1;
+            while (digit <= bucket_count) {
+                count[digit] += count[digit - 1];
+                digit++;
+            }
+
+            std::copy(count.begin(), count.begin() + bucket_count, next_free.begin());
+            current = start;
+            while (current <= end) {
+                const unsigned bucket = (items[current].word >> shift) & digit_mask;
+                buffer[start + next_free[bucket]++] = std::move(items[current]);
+                current++;
+            }
+            std::move(buffer.begin() + start, buffer.begin() + end + 1, items.begin() + start);
+
+            digit = 0;
+            while (digit < bucket_count) {
+                const Index bucket_start = start + count[digit];
+                const Index bucket_last = start + count[digit + 1] - 1;
+                if (digit != largest && bucket_start < bucket_last)
+                    pending.push_back({bucket_start, bucket_last, task.depth + digitAdvance(digit_bytes, digit),
+                                       task.cache_depth});
+                digit++;
+            }
+            task = {start + count[largest], start + count[largest + 1] - 1,
+                    task.depth + digitAdvance(digit_bytes, largest), task.cache_depth};
+        }
+    }
+}
+
+}  // namespace detail
+
+// MSD radix sort on cached key words: every element is paired with the next
+// eight bytes of its key, the digits are read from that word, and the key
+// itself is only read again to refill the word once its bytes are used up.
+// Costs two copies of the range; pays off when the keys are scattered over
+// memory. Not stable.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void cachedRadixSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    using Item = std::iter_value_t<RandomIt>;
+    const detail::Index size = last - first;
+    if (size < 2) return;
+
+    std::vector<detail::CachedKey<Item>> items;
+    items.reserve(size);
+    detail::Index i = 0;
+    while (i < size) {
+        items.push_back({detail::packedWordAt(detail::keyOf(proj, first[i]), 0), std::move(first[i])});
+        i++;
+    }
+
+    std::vector<detail::CachedKey<Item>> buffer(size);
+    detail::cachedRadixSort(items, buffer, proj);
+
+    i = 0;
+    while (i < size) {
+        first[i] = std::move(items[i].item);
+        i++;
+    }
+}
+
+}  // namespace stringsort
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace stringsort {
+
+// Every sort takes a projection from an element to the bytes it is ordered
+// by, as the std::ranges algorithms do; the default sorts the elements
+// themselves. The projection must return a view of (or a reference into)
+// the element: the sorts hold on to keys while they move elements around.
+namespace detail {
+
+using Index = std::ptrdiff_t;
+
+const Index insertion_sort_threshold = 16;
+
+struct SortTask {
+    Index start;
+    Index end;
+    Index depth;
+};
+
+template <typename RandomIt, typename Proj>
+constexpr void checkProjection() {
+    using Result = std::invoke_result_t<Proj&, std::iter_reference_t<RandomIt>>;
+    static_assert(std::is_convertible_v<Result, std::string_view>,
+                  "the projection must yield something convertible to std::string_view");
+    static_assert(std::is_reference_v<Result> ||
+                  !std::is_same_v<std::remove_cv_t<Result>, std::string>,
+                  "the projection returns a temporary std::string; return a reference or a view");
+}
+
+template <typename Proj, typename Item>
+std::string_view keyOf(Proj& proj, Item&& item) {
+    return std::string_view(std::invoke(proj, std::forward<Item>(item)));
+}
+
+// All keys in first[start, end] share their first `depth` characters, so
+// only the suffixes need comparing.
+template <typename RandomIt, typename Proj>
+void insertionSortSuffixes(RandomIt first, Index start, Index end, Index depth, Proj& proj) {
+    Index i = start + 1;
+    while (i <= end) {
+        std::iter_value_t<RandomIt> item = std::move(first[i]);
+        std::string_view key_suffix = keyOf(proj, item).substr(depth);
+        Index j = i - 1;
+        while (j >= start && keyOf(proj, first[j]).substr(depth) > key_suffix) {
+            first[j + 1] = std::move(first[j]);
+            j--;
+        }
+        first[j + 1] = std::move(item);
+        i++;
+    }
+}
+
+// The eight bytes of key from depth, big-endian and zero-padded past its
+// end, so that comparing words compares those bytes.
+inline uint64_t packedWordAt(std::string_view key, Index depth) {
+    uint64_t word = 0;
+    int i = 0;
+    if (static_cast<size_t>(depth) + 8 <= key.size()) {
+        std::memcpy(&word, key.data() + depth, 8);
+        if constexpr (std::endian::native == std::endian::little)
+            word = __builtin_bswap64(word);
+        return word;
+    }
+    while (i < 8) {
+        word <<= 8;
+        if (static_cast<size_t>(depth + i) < key.size())
+            word |= static_cast<unsigned char>(key[depth + i]);
+        i++;
+    }
+    return word;
+}
+
+// Keys whose words equal `word` share its bytes up to the first zero byte,
+// which may be where a key ends. A zero first byte is a real NUL (ended
+// keys are moved out before every pass), so at least one byte is shared.
+inline Index sharedBytes(uint64_t word) {
+    Index bytes = 0;
+    while (bytes < 8 && (word >> (56 - 8 * bytes) & 0xff) != 0) {
+        bytes++;
+    }
+    return std::max<Index>(bytes, 1);
+}
+
+}  // namespace detail
+
+// Byte at depth as 0..255, or -1 once the string has ended, so that ended
+// strings sort before every longer string without a separate pass.
+inline int charAtDepth(std::string_view str, std::ptrdiff_t depth) {
+    return static_cast<size_t>(depth) < str.length() ?
+           static_cast<unsigned char>(str[depth]) : -1;
+}
+
+// Stable insertion sort for small ranges whose keys are known to share
+// their first depth bytes; only the bytes from depth on are compared.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void insertionSortFrom(RandomIt first, RandomIt last, size_t depth, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    detail::insertionSortSuffixes(first, 0, (last - first) - 1, depth, proj);
+}
+
+}  // namespace stringsort
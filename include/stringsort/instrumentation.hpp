@@ -0,0 +1,191 @@
+#pragma once
+
+// Measuring aids for the programs and benchmarks; not part of
+// stringsort.hpp.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define STRINGSORT_HAVE_PERF_EVENTS 1
+#endif
+
+namespace stringsort {
+
+// Allocations made through operator new. They are only counted in a program
+// that defines STRINGSORT_COUNT_ALLOCATIONS before including this header,
+// which replaces the global operator new; do that in one file, the one with
+// main().
+inline std::atomic<long long> allocation_count{0};
+inline std::atomic<long long> allocated_bytes{0};
+
+// Hardware counters of the calling thread (cycles, instructions, cache
+// misses, branch misses) as one perf_event group that keeps counting from
+// construction on. Without perf events every value reads as -1.
+class PerfCounters {
+public:
+    static const int counter_count = 4;
+    using Values = std::array<long long, counter_count>;
+
+    PerfCounters() {
+#ifdef STRINGSORT_HAVE_PERF_EVENTS
+        const uint64_t configs[counter_count] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        int i = 0;
+        while (i < counter_count) {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds_[i] = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+            if (fds_[i] < 0) {
+                close();
+                return;
+            }
+            i++;
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+        close();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        return fds_[0] >= 0;
+    }
+
+    Values read() const {
+        Values values;
+        values.fill(-1);
+#ifdef STRINGSORT_HAVE_PERF_EVENTS
+        uint64_t buffer[1 + counter_count];
+        if (fds_[0] >= 0 &&
+            ::read(fds_[0], buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer))) {
+            int i = 0;
+            while (i < counter_count) {
+                values[i] = buffer[1 + i];
+                i++;
+            }
+        }
+#endif
+        return values;
+    }
+
+private:
+    void close() {
+#ifdef STRINGSORT_HAVE_PERF_EVENTS
+        for (int& fd : fds_) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    int fds_[counter_count] = {-1, -1, -1, -1};
+};
+
+// Splits a run into named phases (parse, sort, output, ...). Each mark()
+// closes the phase that began at the previous mark and records its wall
+// time, allocations and hardware counter deltas; report() prints them as
+// CSV on stderr. Allocations read 0 unless STRINGSORT_COUNT_ALLOCATIONS is
+// defined.
+class PhaseLog {
+public:
+    PhaseLog() {
+        last_ = snapshot();
+    }
+
+    void mark(const std::string& phase) {
+        Snapshot now = snapshot();
+        phases_.push_back({phase, now.time - last_.time});
+        Entry& entry = phases_.back();
+        entry.allocations = now.allocations - last_.allocations;
+        entry.allocated_bytes = now.allocated_bytes - last_.allocated_bytes;
+        int i = 0;
+        while (i < PerfCounters::counter_count) {
+            entry.counters[i] = now.counters[i] < 0 ? -1 : now.counters[i] - last_.counters[i];
+            i++;
+        }
+        last_ = now;
+    }
+
+    void report() const {
+        std::cerr << "phase,microseconds,allocations,allocated_bytes,"
+                  << "cycles,instructions,cache_misses,branch_misses\n";
+        for (const Entry& entry : phases_) {
+            std::cerr << entry.phase << ','
+                      << std::chrono::duration<double, std::micro>(entry.elapsed).count() << ','
+                      << entry.allocations << ',' << entry.allocated_bytes;
+            for (long long value : entry.counters) {
+                std::cerr << ',';
+                if (value >= 0) std::cerr << value;
+            }
+            std::cerr << '\n';
+        }
+    }
+
+private:
+    struct Snapshot {
+        std::chrono::steady_clock::time_point time;
+        long long allocations;
+        long long allocated_bytes;
+        PerfCounters::Values counters;
+    };
+
+    struct Entry {
+        std::string phase;
+        std::chrono::steady_clock::duration elapsed;
+        long long allocations = 0;
+        long long allocated_bytes = 0;
+        PerfCounters::Values counters{};
+    };
+
+    Snapshot snapshot() const {
+        return {std::chrono::steady_clock::now(), allocation_count.load(),
+                allocated_bytes.load(), counters_.read()};
+    }
+
+    PerfCounters counters_;
+    Snapshot last_;
+    std::vector<Entry> phases_;
+};
+
+}  // namespace stringsort
+
+#ifdef STRINGSORT_COUNT_ALLOCATIONS
+// Out of line so that GCC does not pair an inlined free() with the
+// allocation and warn about a mismatch.
+[[gnu::noinline]] void* operator new(size_t size) {
+    stringsort::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    stringsort::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#endif
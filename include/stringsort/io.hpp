@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define STRINGSORT_HAVE_MMAP 1
+#endif
+
+namespace stringsort {
+
+using StringVector = std::vector<std::string_view>;
+
+// All strings back to back in one buffer, so that reading n strings costs a
+// handful of allocations instead of one per string.
+class StringPool {
+public:
+    void reserve(size_t string_count) {
+        offsets_.reserve(string_count + 1);
+    }
+
+    void append(std::string_view str) {
+        if (offsets_.empty())
+            offsets_.push_back(0);
+        bytes_.insert(bytes_.end(), str.begin(), str.end());
+        offsets_.push_back(bytes_.size());
+    }
+
+    size_t size() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    // Bytes held by the arena plus the offset and view handle of every string.
+    size_t memoryUsage() const {
+        return bytes_.size() + size() * (sizeof(size_t) + sizeof(std::string_view));
+    }
+
+    void clear() {
+        bytes_.clear();
+        offsets_.clear();
+    }
+
+    StringVector views() const {
+        StringVector result(size());
+        size_t i = 0;
+        while (i < result.size()) {
+            result[i] = std::string_view(bytes_.data() + offsets_[i],
+                                         offsets_[i + 1] - offsets_[i]);
+            i++;
+        }
+        return result;
+    }
+
+private:
+    std::vector<char> bytes_;
+    std::vector<size_t> offsets_;
+};
+
+// Read-only view of a whole input file. Uses mmap where available so that
+// string handles can point straight into the page cache; elsewhere the file
+// is read into one buffer.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef STRINGSORT_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info{};
+        if (::fstat(fd, &info) == 0) {
+            if (info.st_size > 0) {
+                void* address = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED) {
+                    ::madvise(address, info.st_size, MADV_SEQUENTIAL);
+                    data_ = static_cast<const char*>(address);
+                    size_ = info.st_size;
+                }
+            }
+            opened_ = info.st_size == 0 || data_ != nullptr;
+        }
+        ::close(fd);
+#else
+        std::ifstream input(path, std::ios::binary);
+        if (!input) return;
+        buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        opened_ = true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef STRINGSORT_HAVE_MMAP
+        if (data_ != nullptr)
+            ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const {
+        return opened_;
+    }
+
+    std::string_view contents() const {
+        return std::string_view(data_ == nullptr ? "" : data_, size_);
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool opened_ = false;
+#ifndef STRINGSORT_HAVE_MMAP
+    std::vector<char> buffer_;
+#endif
+};
+
+namespace detail {
+
+// Appends the lines of data to lines, at most max_lines of them, and returns
+// the rest of data. Line ends are found with memchr, which the C library
+// vectorises; a trailing \r is dropped and every line is a handle into data.
+inline std::string_view appendLines(std::string_view data, size_t max_lines, StringVector& lines) {
+    size_t added = 0;
+    while (added < max_lines && !data.empty()) {
+        const char* newline = static_cast<const char*>(
+            std::memchr(data.data(), '\n', data.size()));
+        const size_t line_end = newline != nullptr ? newline - data.data() : data.size();
+        std::string_view line = data.substr(0, line_end);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        lines.push_back(line);
+        data.remove_prefix(std::min(line_end + 1, data.size()));
+        added++;
+    }
+    return data;
+}
+
+}  // namespace detail
+
+// Every line of data, without a count line; the record mode of a1rq sorts
+// log files and TSV tables as they are.
+inline StringVector splitLines(std::string_view data) {
+    StringVector lines;
+    detail::appendLines(data, std::numeric_limits<size_t>::max(), lines);
+    return lines;
+}
+
+// Input in the usual format (a count, then one string per line) that has
+// already been loaded into memory.
+inline StringVector splitInputLines(std::string_view data) {
+    StringVector strings;
+    StringVector count_line;
+    data = detail::appendLines(data, 1, count_line);
+    if (count_line.empty()) return strings;
+
+    size_t string_count = 0;
+    std::from_chars(count_line[0].data(), count_line[0].data() + count_line[0].size(), string_count);
+    strings.reserve(string_count);
+    detail::appendLines(data, string_count, strings);
+    return strings;
+}
+
+// The same format read line by line from standard input, so a string may
+// contain spaces exactly as in splitInputLines.
+inline StringPool readInputStrings() {
+    StringPool pool;
+    std::string line;
+    if (!std::getline(std::cin, line)) return pool;
+
+    size_t string_count = 0;
+    std::from_chars(line.data(), line.data() + line.size(), string_count);
+    pool.reserve(string_count);
+    size_t i = 0;
+    while (i < string_count && std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        pool.append(line);
+        i++;
+    }
+    return pool;
+}
+
+const size_t output_buffer_size = 1 << 20;
+
+// Copies the sorted strings into one large buffer and hands it to the C
+// library in big blocks instead of formatting every line through iostreams.
+inline void printSortedStrings(const StringVector& strings) {
+    std::vector<char> buffer;
+    buffer.reserve(output_buffer_size);
+    for (std::string_view str : strings) {
+        if (buffer.size() + str.size() + 1 > output_buffer_size && !buffer.empty()) {
+            std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+            buffer.clear();
+        }
+        buffer.insert(buffer.end(), str.begin(), str.end());
+        buffer.push_back('\n');
+    }
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+    std::fflush(stdout);
+}
+
+}  // namespace stringsort
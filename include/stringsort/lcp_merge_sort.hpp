@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/mismatch.hpp"
+
+namespace stringsort {
+
+// A key in a run of the LCP merge sort: lcp is its common prefix with the
+// key before it in the run, index its position in the input.
+struct StringWithLCP {
+    std::string_view str;
+    size_t lcp;
+    size_t index;
+};
+
+// Merges the sorted runs a and b into out. Every .lcp holds the LCP with
+// the preceding string of its run; a_head and b_head are the LCPs of a[0]
+// and b[0] with the string written just before out[0]. The output gets the
+// same LCP layout. Ties take from a, which keeps the sort stable.
+inline void mergeSortedParts(const StringWithLCP* a, size_t a_size, size_t a_head,
+                             const StringWithLCP* b, size_t b_size, size_t b_head,
+                             StringWithLCP* out) {
+    size_t a_idx = 0;
+    size_t b_idx = 0;
+    size_t current_pos = 0;
+
+    while (a_idx < a_size && b_idx < b_size) {
+        bool take_a;
+        if (a_head > b_head) {
+            take_a = true;
+        }
+        else if (a_head < b_head) {
+            take_a = false;
+        }
+        else {
+            auto [comparison_result, new_lcp] =
+                compareStringsByLCP(a[a_idx].str, b[b_idx].str, a_head);
+            take_a = comparison_result <= 0;
+            if (take_a)
+                b_head = new_lcp;
+            else
+                a_head = new_lcp;
+        }
+
+        if (take_a) {
+            out[current_pos] = {a[a_idx].str, a_head, a[a_idx].index};
+            a_idx++;
+            if (a_idx < a_size)
+                a_head = a[a_idx].lcp;
+        }
+        else {
+            out[current_pos] = {b[b_idx].str, b_head, b[b_idx].index};
+            b_idx++;
+            if (b_idx < b_size)
+                b_head = b[b_idx].lcp;
+        }
+        current_pos++;
+    }
+
+    while (a_idx < a_size) {
+        out[current_pos] = {a[a_idx].str, a_head, a[a_idx].index};
+        a_idx++;
+        if (a_idx < a_size)
+            a_head = a[a_idx].lcp;
+        current_pos++;
+    }
+
+    while (b_idx < b_size) {
+        out[current_pos] = {b[b_idx].str, b_head, b[b_idx].index};
+        b_idx++;
+        if (b_idx < b_size)
+            b_head = b[b_idx].lcp;
+        current_pos++;
+    }
+}
+
+// Sorts source[0, size) and leaves the result in target if into_target is
+// set, in source otherwise; the other array is scratch space. The halves are
+// sorted into the opposite array, so each merge moves the data across once
+// and nothing is allocated during the sort.
+inline void performMergeSort(StringWithLCP* source, StringWithLCP* target,
+                             size_t size, bool into_target) {
+    if (size == 0) return;
+    if (size == 1) {
+        source[0].lcp = 0;
+        if (into_target)
+            target[0] = source[0];
+        return;
+    }
+
+    const size_t middle = size / 2;
+    performMergeSort(source, target, middle, !into_target);
+    performMergeSort(source + middle, target + middle, size - middle, !into_target);
+
+    const StringWithLCP* from = into_target ? source : target;
+    StringWithLCP* to = into_target ? target : source;
+    mergeSortedParts(from, middle, 0, from + middle, size - middle, 0, to);
+}
+
+// Stable LCP merge sort. Returns the LCP array of the sorted range: entry k
+// is the common prefix of elements k - 1 and k, and entry 0 is 0. The merges
+// compute it anyway, and it is what front coding or a suffix-style search
+// over the output needs.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+std::vector<size_t> lcpMergeSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const size_t size = last - first;
+    std::vector<StringWithLCP> sorted(size);
+    size_t idx = 0;
+    while (idx < size) {
+        sorted[idx] = {detail::keyOf(proj, first[idx]), 0, idx};
+        idx++;
+    }
+    std::vector<StringWithLCP> buffer(size);
+    performMergeSort(sorted.data(), buffer.data(), size, false);
+
+    std::vector<std::iter_value_t<RandomIt>> items;
+    items.reserve(size);
+    std::vector<size_t> lcp(size);
+    idx = 0;
+    while (idx < size) {
+        items.push_back(std::move(first[sorted[idx].index]));
+        lcp[idx] = sorted[idx].lcp;
+        idx++;
+    }
+    std::move(items.begin(), items.end(), first);
+    return lcp;
+}
+
+}  // namespace stringsort
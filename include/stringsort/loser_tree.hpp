@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/mismatch.hpp"
+
+namespace stringsort {
+
+// A sorted stream of strings for LcpLoserTree, which merges k of them.
+class SortedSource {
+public:
+    virtual ~SortedSource() = default;
+
+    // Advances to the next string; false once the source is exhausted.
+    virtual bool next() = 0;
+    virtual std::string_view current() const = 0;
+    // LCP of current() with the string this source returned before it.
+    virtual size_t currentLcp() const = 0;
+    // Whether next() returned false because of an error rather than at the
+    // end of the source.
+    virtual bool failed() const {
+        return false;
+    }
+};
+
+// A sorted range [first, last) of elements ordered by the keys proj gives,
+// as the sorts take them. The elements must outlive the source.
+template <std::forward_iterator It, typename Proj = std::identity>
+class RangeSource : public SortedSource {
+public:
+    RangeSource(It first, It last, Proj proj = {}) : position_(first), last_(last), proj_(proj) {}
+
+    bool next() override {
+        std::string_view previous;
+        if (started_) {
+            previous = current();
+            ++position_;
+        }
+        if (position_ == last_)
+            return false;
+        lcp_ = started_ ? compareStringsByLCP(current(), previous, 0).second : 0;
+        started_ = true;
+        return true;
+    }
+
+    std::string_view current() const override {
+        return detail::keyOf(proj_, *position_);
+    }
+
+    size_t currentLcp() const override {
+        return lcp_;
+    }
+
+    // The element current() is the key of.
+    It position() const {
+        return position_;
+    }
+
+private:
+    It position_;
+    It last_;
+    Proj proj_;
+    size_t lcp_ = 0;
+    bool started_ = false;
+};
+
+// A sorted text file, one string per line.
+class FileSource : public SortedSource {
+public:
+    explicit FileSource(const std::filesystem::path& path) : input_(path, std::ios::binary) {}
+
+    bool next() override {
+        previous_.swap(current_);
+        if (!std::getline(input_, current_))
+            return false;
+        lcp_ = compareStringsByLCP(current_, previous_, 0).second;
+        return true;
+    }
+
+    std::string_view current() const override {
+        return current_;
+    }
+
+    size_t currentLcp() const override {
+        return lcp_;
+    }
+
+    // The file did not open or a read failed.
+    bool failed() const override {
+        return !input_.is_open() || input_.bad();
+    }
+
+private:
+    std::ifstream input_;
+    std::string current_;
+    std::string previous_;
+    size_t lcp_ = 0;
+};
+
+// Tournament tree over k sorted sources. Every internal node keeps the loser
+// of its match together with the loser's LCP against the node's winner.
+// After the overall winner is taken, only its leaf-to-root path is replayed,
+// and the stored LCPs decide most matches without touching any characters.
+class LcpLoserTree {
+public:
+    explicit LcpLoserTree(std::vector<std::unique_ptr<SortedSource>> sources)
+        : sources_(std::move(sources)) {
+        const int source_count = sources_.size();
+        leaf_count_ = 1;
+        while (leaf_count_ < source_count)
+            leaf_count_ *= 2;
+
+        exhausted_.assign(leaf_count_, true);
+        int i = 0;
+        while (i < source_count) {
+            exhausted_[i] = !sources_[i]->next();
+            i++;
+        }
+
+        std::vector<Node> winners(2 * leaf_count_);
+        nodes_.assign(leaf_count_, {0, 0});
+        i = 0;
+        while (i < leaf_count_) {
+            winners[leaf_count_ + i] = {i, 0};
+            i++;
+        }
+        int node = leaf_count_ - 1;
+        while (node >= 1) {
+            Node winner = winners[2 * node];
+            nodes_[node] = winners[2 * node + 1];
+            playMatch(nodes_[node], winner);
+            winners[node] = winner;
+            node--;
+        }
+        nodes_[0] = leaf_count_ > 1 ? winners[1] : winners[leaf_count_];
+    }
+
+    bool empty() const {
+        return exhausted_[nodes_[0].source];
+    }
+
+    std::string_view top() const {
+        return sources_[nodes_[0].source]->current();
+    }
+
+    // Index of the source top() comes from.
+    int topSource() const {
+        return nodes_[0].source;
+    }
+
+    // LCP of top() with the previously returned string.
+    size_t topLcp() const {
+        return nodes_[0].lcp;
+    }
+
+    void pop() {
+        const int source = nodes_[0].source;
+        Node contender = {source, 0};
+        if (sources_[source]->next()) {
+            contender.lcp = sources_[source]->currentLcp();
+        } else {
+            exhausted_[source] = true;
+        }
+
+        int node = (leaf_count_ + source) / 2;
+        while (node >= 1) {
+            playMatch(nodes_[node], contender);
+            node /= 2;
+        }
+        nodes_[0] = contender;
+    }
+
+private:
+    struct Node {
+        int source;
+        size_t lcp;
+    };
+
+    // Both LCPs are relative to the same string (the previous winner), so the
+    // larger LCP belongs to the smaller string. Equal LCPs fall back to a
+    // character comparison that starts after the shared prefix. Ties go to
+    // the lower source index so that the merge is stable.
+    void playMatch(Node& loser, Node& winner) {
+        if (exhausted_[loser.source])
+            return;
+        if (exhausted_[winner.source] || loser.lcp > winner.lcp) {
+            std::swap(loser, winner);
+            return;
+        }
+        if (loser.lcp < winner.lcp)
+            return;
+
+        auto [comparison_result, new_lcp] =
+            compareStringsByLCP(sources_[loser.source]->current(),
+                                sources_[winner.source]->current(), winner.lcp);
+        if (comparison_result < 0 ||
+            (comparison_result == 0 && loser.source < winner.source)) {
+            std::swap(loser.source, winner.source);
+        }
+        loser.lcp = new_lcp;
+    }
+
+    std::vector<std::unique_ptr<SortedSource>> sources_;
+    std::vector<Node> nodes_;
+    std::vector<bool> exhausted_;
+    int leaf_count_;
+};
+
+// Merges sorted runs, each a [first, last) pair of iterators to elements
+// ordered by proj, into out. Equal keys come out in the order of their runs.
+// Returns the end of the output.
+template <std::forward_iterator It, typename OutputIt, typename Proj = std::identity>
+OutputIt mergeSortedRuns(const std::vector<std::pair<It, It>>& runs, OutputIt out, Proj proj = {}) {
+    std::vector<std::unique_ptr<SortedSource>> sources;
+    std::vector<const RangeSource<It, Proj>*> ranges;
+    for (const auto& [first, last] : runs) {
+        auto source = std::make_unique<RangeSource<It, Proj>>(first, last, proj);
+        ranges.push_back(source.get());
+        sources.push_back(std::move(source));
+    }
+
+    LcpLoserTree tree(std::move(sources));
+    while (!tree.empty()) {
+        *out = *ranges[tree.topSource()]->position();
+        ++out;
+        tree.pop();
+    }
+    return out;
+}
+
+}  // namespace stringsort
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define STRINGSORT_HAVE_X86_SIMD 1
+#endif
+
+namespace stringsort {
+
+// Index of the first byte at or after `from` where a and b differ, or
+// `limit` if they agree up to it. The SIMD versions compare 16 or 32 bytes
+// per step; the portable one compares 8-byte words.
+inline size_t findMismatchScalar(const char* a, const char* b, size_t from, size_t limit) {
+    size_t i = from;
+    while (i + 8 <= limit) {
+        uint64_t word_a;
+        uint64_t word_b;
+        std::memcpy(&word_a, a + i, 8);
+        std::memcpy(&word_b, b + i, 8);
+        uint64_t diff = word_a ^ word_b;
+        if (diff != 0) {
+            if constexpr (std::endian::native == std::endian::little)
+                return i + std::countr_zero(diff) / 8;
+            else
+                return i + std::countl_zero(diff) / 8;
+        }
+        i += 8;
+    }
+    while (i < limit && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+#ifdef STRINGSORT_HAVE_X86_SIMD
+__attribute__((target("sse2")))
+inline size_t findMismatchSse2(const char* a, const char* b, size_t from, size_t limit) {
+    size_t i = from;
+    while (i + 16 <= limit) {
+        __m128i block_a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i block_b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        unsigned mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(block_a, block_b)) & 0xffffu;
+        if (mask != 0)
+            return i + std::countr_zero(mask);
+        i += 16;
+    }
+    return findMismatchScalar(a, b, i, limit);
+}
+
+__attribute__((target("avx2")))
+inline size_t findMismatchAvx2(const char* a, const char* b, size_t from, size_t limit) {
+    size_t i = from;
+    while (i + 32 <= limit) {
+        __m256i block_a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i block_b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block_a, block_b)));
+        if (mask != 0)
+            return i + std::countr_zero(mask);
+        i += 32;
+    }
+    return findMismatchSse2(a, b, i, limit);
+}
+#endif
+
+using MismatchKernel = size_t (*)(const char*, const char*, size_t, size_t);
+
+inline MismatchKernel selectMismatchKernel() {
+#ifdef STRINGSORT_HAVE_X86_SIMD
+    if (__builtin_cpu_supports("avx2"))
+        return findMismatchAvx2;
+    return findMismatchSse2;
+#else
+    return findMismatchScalar;
+#endif
+}
+
+// Chosen once per program, whichever translation unit gets there first.
+inline const MismatchKernel findMismatch = selectMismatchKernel();
+
+// Compares a and b, which are known to agree on their first start_from
+// bytes. Returns the sign of the comparison (unsigned bytes, a proper prefix
+// first) and the length of their common prefix.
+inline std::pair<int, size_t> compareStringsByLCP(std::string_view first_str,
+                                                std::string_view second_str,
+                                                size_t start_from) {
+    const size_t first_len = first_str.length();
+    const size_t second_len = second_str.length();
+    const size_t limit = std::min(first_len, second_len);
+    const size_t lcp_length = start_from >= limit ? limit :
+        findMismatch(first_str.data(), second_str.data(), start_from, limit);
+
+    if (lcp_length == first_len && lcp_length == second_len)
+        return {0, lcp_length};
+    if (lcp_length == first_len)
+        return {-1, lcp_length};
+    if (lcp_length == second_len)
+        return {1, lcp_length};
+
+    return (static_cast<unsigned char>(first_str[lcp_length]) <
+            static_cast<unsigned char>(second_str[lcp_length])) ?
+           std::make_pair(-1, lcp_length) :
+           std::make_pair(1, lcp_length);
+}
+
+}  // namespace stringsort
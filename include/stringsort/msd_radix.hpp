@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/multikey_quicksort.hpp"
+
+namespace stringsort {
+namespace detail {
+
+// Below this size radixQuickSort hands a bucket to multikey quicksort.
+const Index switch_to_quick = 74;
+
+// Two-byte digits consume twice as much of the key per pass, but their
+// 65536-bucket histogram only stays cache-friendly when few buckets are
+// occupied. So they are used on large ranges whose keys show at most
+// wide_digit_max_symbols distinct bytes at the current depth in a strided
+// sample: DNA, decimal IDs, long shared prefixes.
+const Index wide_digit_threshold = Index(1) << 16;
+const Index wide_digit_sample = 64;
+const int wide_digit_max_symbols = 16;
+
+// Moves the keys that end at depth to the front; returns the position of
+// the first one that does not.
+template <typename RandomIt, typename Proj>
+Index moveStringsWithCurrentDepthToFront(RandomIt first, Index start, Index end, Index depth, Proj& proj) {
+    Index insert_pos = start;
+    Index current = start;
+
+    while (current <= end) {
+        if (keyOf(proj, first[current]).length() == static_cast<size_t>(depth)) {
+            std::iter_swap(first + insert_pos, first + current);
+            insert_pos++;
+        }
+        current++;
+    }
+    return insert_pos;
+}
+
+// The 8-bit or 16-bit digit of key at depth. A missing second byte reads as
+// zero, like a literal NUL; the recursion tells the two apart.
+template <int DigitBytes>
+unsigned digitAt(std::string_view key, Index depth) {
+    unsigned digit = static_cast<unsigned char>(key[depth]);
+    if constexpr (DigitBytes == 2) {
+        digit <<= 8;
+        if (static_cast<size_t>(depth + 1) < key.size())
+            digit |= static_cast<unsigned char>(key[depth + 1]);
+    }
+    return digit;
+}
+
+// Histogram of one radix pass. Besides the bucket sizes it keeps a bitmap
+// of the occupied buckets, so that the permutation and the recursion visit
+// only those instead of walking all 256 (or 65536) of them.
+template <int DigitBytes>
+struct DigitHistogram {
+    static constexpr int bucket_count = 1 << (8 * DigitBytes);
+    static constexpr int word_count = bucket_count / 64;
+    using Counts = std::conditional_t<DigitBytes == 1, std::array<Index, bucket_count>, std::vector<Index>>;
+
+    // Sizes while counting, then the end of every occupied bucket.
+    Counts bucket_end{};
+    Counts next_free{};
+    std::array<uint64_t, word_count> occupied{};
+    int occupied_count = 0;
+
+    DigitHistogram() {
+        if constexpr (DigitBytes != 1) {
+            bucket_end.assign(bucket_count, 0);
+            next_free.assign(bucket_count, 0);
+        }
+    }
+
+    void add(unsigned digit) {
+        if (bucket_end[digit]++ == 0) {
+            occupied[digit / 64] |= uint64_t(1) << (digit % 64);
+            occupied_count++;
+        }
+    }
+
+    // Calls visit(digit) for every occupied bucket, in digit order.
+    template <typename Visit>
+    void forEachOccupied(Visit visit) const {
+        int word = 0;
+        while (word < word_count) {
+            uint64_t bits = occupied[word];
+            while (bits != 0) {
+                visit(word * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+            word++;
+        }
+    }
+};
+
+template <typename RandomIt, typename Proj>
+bool useWideDigits(RandomIt first, Index start, Index end, Index depth, Proj& proj) {
+    const Index size = end - start + 1;
+    if (size < wide_digit_threshold) return false;
+
+    std::array<uint64_t, 4> seen{};
+    int distinct = 0;
+    Index sample = 0;
+    while (sample < wide_digit_sample) {
+        unsigned char c = keyOf(proj, first[start + sample * size / wide_digit_sample])[depth];
+        if ((seen[c / 64] >> (c % 64) & 1) == 0) {
+            seen[c / 64] |= uint64_t(1) << (c % 64);
+            distinct++;
+            if (distinct > wide_digit_max_symbols) return false;
+        }
+        sample++;
+    }
+    return true;
+}
+
+// How far a bucket of a pass over DigitBytes-byte digits advances the
+// depth. A zero low byte of a 16-bit digit may be the end of the key rather
+// than a NUL, so such buckets only move past the high byte and the next pass
+// tells the two apart.
+inline Index digitAdvance(int digit_bytes, unsigned digit) {
+    return (digit_bytes == 2 && (digit & 0xff) == 0) ? 1 : digit_bytes;
+}
+
+// Counts the digits at depth of first[start, end], whose keys are all
+// longer than depth, and permutes the keys into their buckets in place
+// (American flag sort). Afterwards bucket_end holds the end of every
+// occupied bucket. When every key lands in one bucket nothing is moved.
+template <int DigitBytes, typename RandomIt, typename Proj>
+void distributeByDigit(RandomIt first, Index start, Index end, Index depth,
+                       DigitHistogram<DigitBytes>& histogram, Proj& proj) {
+    Index current = start;
+    while (current <= end) {
+        histogram.add(digitAt<DigitBytes>(keyOf(proj, first[current]), depth));
+        current++;
+    }
+
+    Index offset = start;
+    histogram.forEachOccupied([&](int digit) {
+        histogram.next_free[digit] = offset;
+        offset += histogram.bucket_end[digit];
+        histogram.bucket_end[digit] = offset;
+    });
+    if (histogram.occupied_count == 1) return;
+
+    histogram.forEachOccupied([&](int bucket) {
+        while (histogram.next_free[bucket] < histogram.bucket_end[bucket]) {
+            std::iter_value_t<RandomIt> item = std::move(first[histogram.next_free[bucket]]);
+            unsigned digit = digitAt<DigitBytes>(keyOf(proj, item), depth);
+            while (digit != static_cast<unsigned>(bucket)) {
+                using std::swap;
+                swap(item, first[histogram.next_free[digit]]);
+                histogram.next_free[digit]++;
+                digit = digitAt<DigitBytes>(keyOf(proj, item), depth);
+            }
+            first[histogram.next_free[bucket]] = std::move(item);
+            histogram.next_free[bucket]++;
+        }
+    });
+}
+
+template <typename RandomIt, typename Proj>
+void msdRadixSort(RandomIt first, Index start, Index end, Index depth, Index quick_threshold, Proj& proj);
+
+// One distribution of first[start, end], whose keys are all longer than
+// depth. Every occupied bucket with at least two keys but the largest is
+// sorted recursively; each of those holds at most half the range, so the
+// recursion is O(log n) deep. The largest bucket is returned for the
+// caller's loop to carry on with.
+template <int DigitBytes, typename RandomIt, typename Proj>
+SortTask radixPass(RandomIt first, Index start, Index end, Index depth, Index quick_threshold, Proj& proj) {
+    DigitHistogram<DigitBytes> histogram;
+    distributeByDigit(first, start, end, depth, histogram, proj);
+
+    int largest = -1;
+    Index largest_size = 0;
+    Index bucket_start = start;
+    histogram.forEachOccupied([&](int digit) {
+        if (histogram.bucket_end[digit] - bucket_start > largest_size) {
+            largest = digit;
+            largest_size = histogram.bucket_end[digit] - bucket_start;
+        }
+        bucket_start = histogram.bucket_end[digit];
+    });
+
+    SortTask rest = {start, start, depth};
+    bucket_start = start;
+    histogram.forEachOccupied([&](int digit) {
+        const Index bucket_last = histogram.bucket_end[digit] - 1;
+        if (digit == largest)
+            rest = {bucket_start, bucket_last, depth + digitAdvance(DigitBytes, digit)};
+        else if (bucket_start < bucket_last)
+            msdRadixSort(first, bucket_start, bucket_last, depth + digitAdvance(DigitBytes, digit),
+                         quick_threshold, proj);
+        bucket_start = bucket_last + 1;
+    });
+    return rest;
+}
+
+// Ranges below quick_threshold go to multikey quicksort. The largest bucket
+// of every pass, which also covers a range whose keys all share the next
+// digit, loops here instead of recursing: long common prefixes stay cheap
+// and the call stack stays shallow.
+template <typename RandomIt, typename Proj>
+void msdRadixSort(RandomIt first, Index start, Index end, Index depth, Index quick_threshold, Proj& proj) {
+    while (start < end) {
+        if ((end - start + 1) < quick_threshold) {
+            ternaryQuickSort(first, start, end, depth, end + 1, proj);
+            return;
+        }
+
+        start = moveStringsWithCurrentDepthToFront(first, start, end, depth, proj);
+        if (start >= end) return;
+
+        const SortTask rest = useWideDigits(first, start, end, depth, proj) ?
+                              radixPass<2>(first, start, end, depth, quick_threshold, proj) :
+                              radixPass<1>(first, start, end, depth, quick_threshold, proj);
+        start = rest.start;
+        end = rest.end;
+        depth = rest.depth;
+    }
+}
+
+}  // namespace detail
+
+// In-place MSD radix sort (American flag sort) all the way down. Not stable.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void msdRadixSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    detail::msdRadixSort(first, 0, (last - first) - 1, 0, 0, proj);
+}
+
+// MSD radix sort that switches to multikey quicksort on small buckets,
+// where a 256-way pass costs more than it saves. Not stable.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void radixQuickSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    detail::msdRadixSort(first, 0, (last - first) - 1, 0, detail::switch_to_quick, proj);
+}
+
+// radixQuickSort for a range whose keys are known to share their first
+// depth bytes, such as a bucket of a driver built on distributeByByte.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void radixQuickSortFrom(RandomIt first, RandomIt last, size_t depth, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    detail::msdRadixSort(first, 0, (last - first) - 1, depth, detail::switch_to_quick, proj);
+}
+
+// One American flag pass over [first, last), whose keys share their first
+// depth bytes, for drivers that decide what to do with every bucket
+// themselves. Afterwards the keys that end at depth come first and the
+// others follow in the order of their byte at depth. Bucket 0 of the result
+// holds the ended keys and bucket c + 1 the keys whose byte is c: bucket b is
+// [first + bounds[b], first + bounds[b + 1]).
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+std::array<size_t, 258> distributeByByte(RandomIt first, RandomIt last, size_t depth, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const detail::Index end = (last - first) - 1;
+    const detail::Index first_long = detail::moveStringsWithCurrentDepthToFront(first, 0, end, depth, proj);
+    detail::DigitHistogram<1> histogram;
+    detail::distributeByDigit(first, first_long, end, depth, histogram, proj);
+
+    std::array<size_t, 258> bounds{};
+    bounds[1] = first_long;
+    int byte = 0;
+    while (byte < 256) {
+        // The end of an empty bucket was never set and is still zero.
+        bounds[byte + 2] = histogram.bucket_end[byte] != 0 ? histogram.bucket_end[byte] : bounds[byte + 1];
+        byte++;
+    }
+    return bounds;
+}
+
+}  // namespace stringsort
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "stringsort/common.hpp"
+
+namespace stringsort {
+namespace detail {
+
+const Index ninther_threshold = 64;
+
+inline int medianOfThree(int a, int b, int c) {
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// Median of three characters, or Tukey's ninther on larger ranges.
+template <typename RandomIt, typename Proj>
+int choosePivotChar(RandomIt first, Index left, Index right, Index depth, Proj& proj) {
+    auto at = [first, depth, &proj](Index i) { return charAtDepth(keyOf(proj, first[i]), depth); };
+    const Index size = right - left + 1;
+    const Index middle = left + size / 2;
+    if (size < ninther_threshold)
+        return medianOfThree(at(left), at(middle), at(right));
+
+    const Index step = size / 8;
+    return medianOfThree(
+        medianOfThree(at(left), at(left + step), at(left + 2 * step)),
+        medianOfThree(at(middle - step), at(middle), at(middle + step)),
+        medianOfThree(at(right - 2 * step), at(right - step), at(right)));
+}
+
+template <typename RandomIt, typename Proj>
+void partitionByPivot(RandomIt first, Index left, Index right, Index depth, int pivot_char,
+                      Index& lower_bound, Index& upper_bound, Proj& proj) {
+    lower_bound = left;
+    upper_bound = right;
+    Index current = left;
+
+    while (current <= upper_bound) {
+        int current_char = charAtDepth(keyOf(proj, first[current]), depth);
+
+        if (current_char < pivot_char) {
+            std::iter_swap(first + lower_bound, first + current);
+            lower_bound++;
+            current++;
+        } else if (current_char > pivot_char) {
+            std::iter_swap(first + current, first + upper_bound);
+            upper_bound--;
+        } else {
+            current++;
+        }
+    }
+}
+
+// The pending ranges of ternaryQuickSort. A partition step pushes at most
+// two ranges, and the range split next is at most half as large as the one
+// that pushed it, so the stack holds at most 2 log2(n) entries. Up to
+// `capacity` of them live in the caller's frame; only more than that would
+// go to the heap.
+class TaskStack {
+public:
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    void push(const SortTask& task) {
+        if (size_ < capacity)
+            local_[size_] = task;
+        else
+            overflow_.push_back(task);
+        size_++;
+    }
+
+    SortTask pop() {
+        size_--;
+        if (size_ < capacity)
+            return local_[size_];
+        const SortTask task = overflow_.back();
+        overflow_.pop_back();
+        return task;
+    }
+
+private:
+    static constexpr Index capacity = 64;
+
+    SortTask local_[capacity];
+    std::vector<SortTask> overflow_;
+    Index size_ = 0;
+};
+
+// Multikey quicksort driven by an explicit stack: of the three partitions
+// the smallest is processed next and the other two are pushed, so neither
+// deep common prefixes nor bad pivots can overflow the call stack. Ranges
+// that start at or after `limit` are dropped instead of sorted, which turns
+// the sort into a partial one.
+template <typename RandomIt, typename Proj>
+void ternaryQuickSort(RandomIt first, Index start, Index end, Index depth, Index limit, Proj& proj) {
+    TaskStack pending;
+    pending.push({start, end, depth});
+
+    while (!pending.empty()) {
+        SortTask task = pending.pop();
+
+        while (task.start < limit && task.end - task.start + 1 > insertion_sort_threshold) {
+            int pivot_char = choosePivotChar(first, task.start, task.end, task.depth, proj);
+            Index lower, upper;
+            partitionByPivot(first, task.start, task.end, task.depth, pivot_char, lower, upper, proj);
+
+            SortTask parts[3] = {
+                {task.start, lower - 1, task.depth},
+                {lower, pivot_char < 0 ? lower - 1 : upper, task.depth + 1},
+                {upper + 1, task.end, task.depth}
+            };
+            std::sort(parts, parts + 3, [](const SortTask& a, const SortTask& b) {
+                return a.end - a.start < b.end - b.start;
+            });
+            if (parts[2].start < limit && parts[2].start < parts[2].end) pending.push(parts[2]);
+            if (parts[1].start < limit && parts[1].start < parts[1].end) pending.push(parts[1]);
+            task = parts[0];
+        }
+
+        if (task.start < limit)
+            insertionSortSuffixes(first, task.start, task.end, task.depth, proj);
+    }
+}
+
+}  // namespace detail
+
+// Multikey (three-way radix) quicksort. Not stable.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void multikeyQuickSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const detail::Index size = last - first;
+    if (size > 1)
+        detail::ternaryQuickSort(first, 0, size - 1, 0, size, proj);
+}
+
+// multikeyQuickSort for a range whose keys are known to share their first
+// depth bytes: the comparisons start at depth.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void multikeyQuickSortFrom(RandomIt first, RandomIt last, size_t depth, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const detail::Index size = last - first;
+    if (size > 1)
+        detail::ternaryQuickSort(first, 0, size - 1, depth, size, proj);
+}
+
+// Like std::partial_sort: [first, middle) receives the smallest elements in
+// order, the rest is left in unspecified order.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void partialMultikeyQuickSort(RandomIt first, RandomIt middle, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const detail::Index size = last - first;
+    if (size > 1 && middle > first)
+        detail::ternaryQuickSort(first, 0, size - 1, 0, middle - first, proj);
+}
+
+// Multikey quickselect, the counterpart of std::nth_element: afterwards *nth
+// is the element that would be there after a full sort, with no larger key
+// before it and no smaller one after it. Only the partition containing nth
+// is followed, and in the middle partition the comparison moves on to the
+// next character.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void multikeyQuickSelect(RandomIt first, RandomIt nth, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    if (nth == last) return;
+    const detail::Index k = nth - first;
+    detail::Index start = 0;
+    detail::Index end = last - first - 1;
+    detail::Index depth = 0;
+
+    while (end - start + 1 > detail::insertion_sort_threshold) {
+        int pivot_char = detail::choosePivotChar(first, start, end, depth, proj);
+        detail::Index lower, upper;
+        detail::partitionByPivot(first, start, end, depth, pivot_char, lower, upper, proj);
+
+        if (k < lower) {
+            end = lower - 1;
+        } else if (k > upper) {
+            start = upper + 1;
+        } else if (pivot_char < 0) {
+            return;
+        } else {
+            start = lower;
+            end = upper;
+            depth++;
+        }
+    }
+
+    detail::insertionSortSuffixes(first, start, end, depth, proj);
+}
+
+}  // namespace stringsort
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/msd_radix.hpp"
+#include "stringsort/work_stealing_pool.hpp"
+
+namespace stringsort {
+namespace detail {
+
+// Below this size a bucket is sorted by the thread that holds it.
+const Index parallel_cutoff = 8192;
+
+// In-place passes over first[start, end]; every bucket of at least two
+// keys becomes a task of its own. A range whose keys all share the byte
+// stays with this task and only moves one byte deeper.
+template <typename RandomIt, typename Proj>
+void parallelRadixTask(WorkStealingPool& pool, RandomIt first, Index start, Index end, Index depth, Proj& proj) {
+    DigitHistogram<1> histogram;
+    while (true) {
+        if (end - start + 1 < parallel_cutoff) {
+            msdRadixSort(first, start, end, depth, switch_to_quick, proj);
+            return;
+        }
+
+        start = moveStringsWithCurrentDepthToFront(first, start, end, depth, proj);
+        if (start >= end) return;
+
+        histogram = {};
+        distributeByDigit(first, start, end, depth, histogram, proj);
+        if (histogram.occupied_count > 1) break;
+        depth++;
+    }
+
+    Index bucket_start = start;
+    histogram.forEachOccupied([&](int digit) {
+        const Index bucket_last = histogram.bucket_end[digit] - 1;
+        if (bucket_start < bucket_last) {
+            pool.submit([&pool, first, bucket_start, bucket_last, depth, &proj] {
+                parallelRadixTask(pool, first, bucket_start, bucket_last, depth + 1, proj);
+            });
+        }
+        bucket_start = bucket_last + 1;
+    });
+}
+
+// Top-level pass: every thread builds a histogram of its own chunk, then
+// scatters the chunk into disjoint slices of a buffer, which the threads
+// move back chunk by chunk. Returns the bucket bounds: bucket 0 holds the
+// keys that are empty, bucket c + 1 the keys that start with c.
+template <typename RandomIt, typename Proj>
+std::array<Index, 258> parallelFirstPass(WorkStealingPool& pool, RandomIt first, Index size, Proj& proj) {
+    const int chunk_count = pool.threadCount();
+    const int bucket_count = 257;
+    std::vector<std::array<Index, 257>> histograms(chunk_count);
+
+    auto bucketOf = [first, &proj](Index i) {
+        std::string_view key = keyOf(proj, first[i]);
+        return key.empty() ? 0 : static_cast<unsigned char>(key[0]) + 1;
+    };
+    auto chunkBegin = [size, chunk_count](int chunk) {
+        return size * chunk / chunk_count;
+    };
+
+    int chunk = 0;
+    while (chunk < chunk_count) {
+        pool.submit([&, chunk] {
+            std::array<Index, 257>& histogram = histograms[chunk];
+            histogram.fill(0);
+            Index current = chunkBegin(chunk);
+            const Index chunk_end = chunkBegin(chunk + 1);
+            while (current < chunk_end) {
+                histogram[bucketOf(current)]++;
+                current++;
+            }
+        });
+        chunk++;
+    }
+    pool.wait();
+
+    std::array<Index, 258> bucket_start{};
+    Index offset = 0;
+    int bucket = 0;
+    while (bucket < bucket_count) {
+        bucket_start[bucket] = offset;
+        chunk = 0;
+        while (chunk < chunk_count) {
+            const Index chunk_size = histograms[chunk][bucket];
+            histograms[chunk][bucket] = offset;
+            offset += chunk_size;
+            chunk++;
+        }
+        bucket++;
+    }
+    bucket_start[bucket_count] = offset;
+
+    std::vector<std::iter_value_t<RandomIt>> buffer(size);
+    chunk = 0;
+    while (chunk < chunk_count) {
+        pool.submit([&, chunk] {
+            std::array<Index, 257>& next_free = histograms[chunk];
+            Index current = chunkBegin(chunk);
+            const Index chunk_end = chunkBegin(chunk + 1);
+            while (current < chunk_end) {
+                buffer[next_free[bucketOf(current)]++] = std::move(first[current]);
+                current++;
+            }
+        });
+        chunk++;
+    }
+    pool.wait();
+
+    chunk = 0;
+    while (chunk < chunk_count) {
+        pool.submit([&, chunk] {
+            std::move(buffer.begin() + chunkBegin(chunk), buffer.begin() + chunkBegin(chunk + 1),
+                      first + chunkBegin(chunk));
+        });
+        chunk++;
+    }
+    pool.wait();
+    return bucket_start;
+}
+
+}  // namespace detail
+
+// radixQuickSort on thread_count threads of a WorkStealingPool. The first
+// pass is split over the threads; below it, every bucket of a pass becomes
+// a task until buckets drop under parallel_cutoff keys. Falls back to
+// radixQuickSort for one thread or small inputs. Not stable.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void parallelRadixQuickSort(RandomIt first, RandomIt last, int thread_count, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const detail::Index size = last - first;
+    if (thread_count <= 1 || size < detail::parallel_cutoff) {
+        detail::msdRadixSort(first, 0, size - 1, 0, detail::switch_to_quick, proj);
+        return;
+    }
+
+    WorkStealingPool pool(thread_count);
+    const std::array<detail::Index, 258> bucket_start = detail::parallelFirstPass(pool, first, size, proj);
+    int bucket = 1;
+    while (bucket <= 256) {
+        const detail::Index start = bucket_start[bucket];
+        const detail::Index end = bucket_start[bucket + 1] - 1;
+        if (start < end) {
+            pool.submit([&pool, first, start, end, &proj] {
+                detail::parallelRadixTask(pool, first, start, end, 1, proj);
+            });
+        }
+        bucket++;
+    }
+    pool.wait();
+}
+
+}  // namespace stringsort
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stringsort/common.hpp"
+#include "stringsort/msd_radix.hpp"
+
+namespace stringsort {
+namespace detail {
+
+// Below this size stringSampleSort hands a range to radixQuickSort: a
+// 511-bucket pass with its sample only pays off on large ranges.
+const Index sample_sort_threshold = Index(1) << 15;
+const int sample_oversampling = 2;
+
+// 255 splitters drawn from a sample, as a complete binary search tree in
+// breadth-first order (4 KiB with the sorted copy, so it stays in L1). A
+// word descends it without branches and lands in one of 511 buckets: even
+// buckets hold the words strictly between two splitters, odd ones the words
+// equal to a splitter.
+struct SplitterTree {
+    static constexpr int levels = 8;
+    static constexpr int splitter_count = (1 << levels) - 1;
+    static constexpr int bucket_count = 2 * splitter_count + 1;
+
+    std::array<uint64_t, splitter_count + 1> tree{};
+    // Sorted, with the last splitter repeated as a sentinel.
+    std::array<uint64_t, splitter_count + 1> splitters{};
+
+    explicit SplitterTree(const std::vector<uint64_t>& sorted_sample) {
+        int i = 0;
+        while (i < splitter_count) {
+            splitters[i] = sorted_sample[(i + 1) * sample_oversampling - 1];
+            i++;
+        }
+        splitters[splitter_count] = splitters[splitter_count - 1];
+        int next = 0;
+        fillTree(1, next);
+    }
+
+    int classify(uint64_t word) const {
+        unsigned node = 1;
+        int level = 0;
+        while (level < levels) {
+            node = 2 * node + (word > tree[node]);
+            level++;
+        }
+        // The leaf reached is the number of splitters below the word.
+        const unsigned leaf = node - (1u << levels);
+        return 2 * leaf + (word == splitters[leaf]);
+    }
+
+    uint64_t splitterOf(int bucket) const {
+        return splitters[bucket / 2];
+    }
+
+private:
+    void fillTree(int node, int& next) {
+        if (node > splitter_count) return;
+        fillTree(2 * node, next);
+        tree[node] = splitters[next++];
+        fillTree(2 * node + 1, next);
+    }
+};
+
+template <typename RandomIt, typename Proj>
+void stringSampleSort(RandomIt first, Index start, Index end, Index depth, std::vector<uint16_t>& oracle, Proj& proj);
+
+// One distribution of first[start, end], whose keys are all longer than
+// depth, by the splitter tree of a strided sample. Every key is classified
+// once and its bucket kept in `oracle`, so the American-flag permutation
+// does not classify it again. Buckets between splitters are sorted again at
+// the same depth; a bucket equal to a splitter moves past the bytes its keys
+// share, like the middle partition of multikey quicksort. As in radixPass
+// only the buckets other than the largest are sorted recursively, and the
+// largest is returned for the caller's loop; if every key lands in one
+// equal bucket nothing is moved.
+template <typename RandomIt, typename Proj>
+SortTask samplePass(RandomIt first, Index start, Index end, Index depth, std::vector<uint16_t>& oracle, Proj& proj) {
+    const Index size = end - start + 1;
+    const Index sample_count = (SplitterTree::splitter_count + 1) * sample_oversampling;
+    std::vector<uint64_t> sample(sample_count);
+    Index i = 0;
+    while (i < sample_count) {
+        sample[i] = packedWordAt(keyOf(proj, first[start + i * size / sample_count]), depth);
+        i++;
+    }
+    std::sort(sample.begin(), sample.end());
+
+    // A sample of a single word usually means a shared prefix; checking that
+    // is much cheaper than classifying every key.
+    Index current = start;
+    if (sample.front() == sample.back()) {
+        while (current <= end && packedWordAt(keyOf(proj, first[current]), depth) == sample.front()) {
+            current++;
+        }
+        if (current > end) return {start, end, depth + sharedBytes(sample.front())};
+    }
+    const SplitterTree tree(sample);
+
+    // Every sampled key is equal to some splitter or lies between two, so
+    // the keys never all end up in one of the buckets between splitters.
+    std::array<Index, SplitterTree::bucket_count> bucket_end{};
+    current = start;
+    while (current <= end) {
+        const int bucket = tree.classify(packedWordAt(keyOf(proj, first[current]), depth));
+        oracle[current] = static_cast<uint16_t>(bucket);
+        bucket_end[bucket]++;
+        current++;
+    }
+
+    const int only_bucket = tree.classify(sample[0]);
+    if (only_bucket % 2 == 1 && bucket_end[only_bucket] == size)
+        return {start, end, depth + sharedBytes(tree.splitterOf(only_bucket))};
+    const int largest = std::max_element(bucket_end.begin(), bucket_end.end()) - bucket_end.begin();
+
+    std::array<Index, SplitterTree::bucket_count> next_free;
+    Index offset = start;
+    int bucket = 0;
+    while (bucket < SplitterTree::bucket_count) {
+        next_free[bucket] = offset;
+        offset += bucket_end[bucket];
+        bucket_end[bucket] = offset;
+        bucket++;
+    }
+
+    bucket = 0;
+    while (bucket < SplitterTree::bucket_count) {
+        while (next_free[bucket] < bucket_end[bucket]) {
+            const Index position = next_free[bucket];
+            std::iter_value_t<RandomIt> item = std::move(first[position]);
+            uint16_t digit = oracle[position];
+            while (digit != bucket) {
+                const Index target = next_free[digit]++;
+                using std::swap;
+                swap(item, first[target]);
+                swap(digit, oracle[target]);
+            }
+            first[position] = std::move(item);
+            next_free[bucket]++;
+        }
+        bucket++;
+    }
+
+    SortTask rest = {start, start, depth};
+    Index bucket_start = start;
+    bucket = 0;
+    while (bucket < SplitterTree::bucket_count) {
+        const Index bucket_last = bucket_end[bucket] - 1;
+        const Index next_depth = bucket % 2 == 1 ? depth + sharedBytes(tree.splitterOf(bucket)) : depth;
+        if (bucket == largest)
+            rest = {bucket_start, bucket_last, next_depth};
+        else if (bucket_start < bucket_last)
+            stringSampleSort(first, bucket_start, bucket_last, next_depth, oracle, proj);
+        bucket_start = bucket_last + 1;
+        bucket++;
+    }
+    return rest;
+}
+
+template <typename RandomIt, typename Proj>
+void stringSampleSort(RandomIt first, Index start, Index end, Index depth, std::vector<uint16_t>& oracle, Proj& proj) {
+    while (start < end) {
+        if ((end - start + 1) < sample_sort_threshold) {
+            msdRadixSort(first, start, end, depth, switch_to_quick, proj);
+            return;
+        }
+
+        start = moveStringsWithCurrentDepthToFront(first, start, end, depth, proj);
+        if (start >= end) return;
+
+        const SortTask rest = samplePass(first, start, end, depth, oracle, proj);
+        start = rest.start;
+        end = rest.end;
+        depth = rest.depth;
+    }
+}
+
+}  // namespace detail
+
+// Super-scalar string sample sort: large ranges are split by a sample of
+// 8-byte key words in one classification pass into 511 buckets, smaller
+// ones are left to radixQuickSort. Needs two bytes per element for the
+// bucket of every key. Not stable.
+template <std::random_access_iterator RandomIt, typename Proj = std::identity>
+void stringSampleSort(RandomIt first, RandomIt last, Proj proj = {}) {
+    detail::checkProjection<RandomIt, Proj>();
+    const detail::Index size = last - first;
+    if (size < detail::sample_sort_threshold) {
+        detail::msdRadixSort(first, 0, size - 1, 0, detail::switch_to_quick, proj);
+        return;
+    }
+    std::vector<uint16_t> oracle(size);
+    detail::stringSampleSort(first, 0, size - 1, 0, oracle, proj);
+}
+
+}  // namespace stringsort
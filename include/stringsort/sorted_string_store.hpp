@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stringsort/io.hpp"
+#include "stringsort/lcp_merge_sort.hpp"
+#include "stringsort/loser_tree.hpp"
+#include "stringsort/mismatch.hpp"
+#include "stringsort/msd_radix.hpp"
+
+namespace stringsort {
+
+// Sorted string store for continuous ingestion. Each inserted batch is
+// copied into its own arena, sorted with radixQuickSort and becomes the
+// newest tier together with its LCP array. While a tier is at least half as
+// large as the next older one, the two are joined with mergeSortedParts, so
+// tier sizes grow geometrically: there are O(log n) tiers and every string
+// takes part in O(log n) merges. Lookups binary-search every tier; scans
+// merge the tiers with the LCP loser tree. Equal strings from different
+// batches come back in the order of their batches.
+class SortedStringStore {
+public:
+    void insert(const StringVector& batch) {
+        if (batch.empty()) return;
+
+        StringPool& pool = pools_.emplace_back();
+        pool.reserve(batch.size());
+        for (std::string_view str : batch)
+            pool.append(str);
+
+        StringVector strings = pool.views();
+        radixQuickSort(strings.begin(), strings.end());
+        Tier tier(strings.size());
+        size_t i = 0;
+        while (i < strings.size()) {
+            const size_t lcp = i == 0 ? 0 : compareStringsByLCP(strings[i - 1], strings[i], 0).second;
+            tier[i] = {strings[i], lcp, i};
+            i++;
+        }
+        tiers_.push_back(std::move(tier));
+
+        while (tiers_.size() >= 2 &&
+               tiers_[tiers_.size() - 2].size() <= 2 * tiers_.back().size()) {
+            const Tier& older = tiers_[tiers_.size() - 2];
+            const Tier& newer = tiers_.back();
+            Tier merged(older.size() + newer.size());
+            mergeSortedParts(older.data(), older.size(), 0, newer.data(), newer.size(), 0, merged.data());
+            tiers_.pop_back();
+            tiers_.back() = std::move(merged);
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Tier& tier : tiers_)
+            total += tier.size();
+        return total;
+    }
+
+    size_t tierCount() const {
+        return tiers_.size();
+    }
+
+    bool contains(std::string_view key) const {
+        for (const Tier& tier : tiers_) {
+            if (std::ranges::binary_search(tier, key, {}, &StringWithLCP::str))
+                return true;
+        }
+        return false;
+    }
+
+    // Calls visit for every stored string s with low <= s < high, in order.
+    void scan(std::string_view low, std::string_view high,
+              const std::function<void(std::string_view)>& visit) const {
+        std::vector<std::unique_ptr<SortedSource>> sources;
+        for (const Tier& tier : tiers_) {
+            auto begin = std::ranges::lower_bound(tier, low, {}, &StringWithLCP::str);
+            auto end = std::ranges::lower_bound(begin, tier.end(), high, {}, &StringWithLCP::str);
+            sources.push_back(std::make_unique<TierSource>(tier, begin - tier.begin(), end - tier.begin()));
+        }
+        visitMerged(std::move(sources), visit);
+    }
+
+    // Same as scan without an upper bound.
+    void scanFrom(std::string_view low, const std::function<void(std::string_view)>& visit) const {
+        std::vector<std::unique_ptr<SortedSource>> sources;
+        for (const Tier& tier : tiers_) {
+            auto begin = std::ranges::lower_bound(tier, low, {}, &StringWithLCP::str);
+            sources.push_back(std::make_unique<TierSource>(tier, begin - tier.begin(), tier.size()));
+        }
+        visitMerged(std::move(sources), visit);
+    }
+
+private:
+    using Tier = std::vector<StringWithLCP>;
+
+    // A slice of a tier; its LCP array is reused as is, only the first
+    // string of the slice starts from 0.
+    class TierSource : public SortedSource {
+    public:
+        TierSource(const Tier& tier, size_t begin, size_t end)
+            : tier_(tier), begin_(begin), end_(end), position_(begin) {}
+
+        bool next() override {
+            if (started_)
+                position_++;
+            started_ = true;
+            return position_ < end_;
+        }
+
+        std::string_view current() const override {
+            return tier_[position_].str;
+        }
+
+        size_t currentLcp() const override {
+            return position_ == begin_ ? 0 : tier_[position_].lcp;
+        }
+
+    private:
+        const Tier& tier_;
+        size_t begin_;
+        size_t end_;
+        size_t position_;
+        bool started_ = false;
+    };
+
+    static void visitMerged(std::vector<std::unique_ptr<SortedSource>> sources,
+                            const std::function<void(std::string_view)>& visit) {
+        LcpLoserTree tree(std::move(sources));
+        while (!tree.empty()) {
+            visit(tree.top());
+            tree.pop();
+        }
+    }
+
+    std::deque<StringPool> pools_;
+    std::vector<Tier> tiers_;
+};
+
+}  // namespace stringsort
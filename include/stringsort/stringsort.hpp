@@ -0,0 +1,37 @@
+#pragma once
+
+// The string sorting engines as header-only templates over random-access
+// iterators and a key projection:
+//
+//   stringsort::lcpMergeSort(first, last, proj)       stable, returns the LCP array
+//   stringsort::multikeyQuickSort(first, last, proj)
+//   stringsort::msdRadixSort(first, last, proj)
+//   stringsort::radixQuickSort(first, last, proj)     the fastest general choice
+//   stringsort::parallelRadixQuickSort(first, last, threads, proj)
+//   stringsort::stringSampleSort(first, last, proj)   for very large inputs
+//   stringsort::cachedRadixSort(first, last, proj)    for long keys scattered over memory
+//
+// plus partialMultikeyQuickSort, multikeyQuickSelect, distributeByByte (one
+// American flag pass, for drivers of their own), and
+// alphabetRadixSort<Alphabet> for keys over a small alphabet known at
+// compile time (DNA, decimal digits, base64, printable ASCII).
+// radixQuickSortFrom, multikeyQuickSortFrom and insertionSortFrom take a
+// depth as well and sort a range whose keys are known to share their first
+// depth bytes, comparing only the bytes after them.
+//
+// Keys are compared as unsigned bytes, a proper prefix first, which is the
+// order of std::string_view::compare and of `LC_ALL=C sort`. Input and
+// output helpers for the command-line programs live in stringsort/io.hpp,
+// the incrementally sorted SortedStringStore in
+// stringsort/sorted_string_store.hpp, and the LCP loser tree with
+// mergeSortedRuns for k sorted runs in stringsort/loser_tree.hpp.
+
+#include "stringsort/alphabet_radix.hpp"
+#include "stringsort/cached_radix.hpp"
+#include "stringsort/common.hpp"
+#include "stringsort/lcp_merge_sort.hpp"
+#include "stringsort/mismatch.hpp"
+#include "stringsort/msd_radix.hpp"
+#include "stringsort/multikey_quicksort.hpp"
+#include "stringsort/parallel_radix.hpp"
+#include "stringsort/sample_sort.hpp"
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stringsort {
+
+// Thread pool with one task deque per thread. A thread pops its own newest
+// task and steals the oldest one of another queue, so recursive sorts that
+// submit their subproblems keep every thread busy. The thread that calls
+// wait() works as thread 0 until every submitted task has run.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int thread_count) {
+        const int queue_count = std::max(thread_count, 1);
+        int i = 0;
+        while (i < queue_count) {
+            queues_.push_back(std::make_unique<TaskQueue>());
+            i++;
+        }
+        i = 1;
+        while (i < queue_count) {
+            workers_.emplace_back([this, i] { workerLoop(i); });
+            i++;
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    int threadCount() const {
+        return queues_.size();
+    }
+
+    void submit(std::function<void()> task) {
+        int index = current_worker_ >= 0 ? current_worker_ : 0;
+        pending_++;
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            queued_++;
+        }
+        sleep_cv_.notify_one();
+    }
+
+    void wait() {
+        current_worker_ = 0;
+        std::function<void()> task;
+        while (pending_ > 0) {
+            if (takeTask(0, task)) {
+                runTask(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        current_worker_ = -1;
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool takeTask(int index, std::function<void()>& task) {
+        const int queue_count = queues_.size();
+        int offset = 0;
+        while (offset < queue_count) {
+            TaskQueue& queue = *queues_[(index + offset) % queue_count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                if (offset == 0) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                } else {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+                queued_--;
+                return true;
+            }
+            offset++;
+        }
+        return false;
+    }
+
+    void runTask(std::function<void()>& task) {
+        task();
+        task = nullptr;
+        pending_--;
+    }
+
+    void workerLoop(int index) {
+        current_worker_ = index;
+        std::function<void()> task;
+        while (true) {
+            if (takeTask(index, task)) {
+                runTask(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (stopping_) return;
+        }
+    }
+
+    static inline thread_local int current_worker_ = -1;
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<int> pending_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    int queued_ = 0;
+    bool stopping_ = false;
+};
+
+}  // namespace stringsort
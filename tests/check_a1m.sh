@@ -0,0 +1,100 @@
+#!/bin/sh
+# Runs a1m on generated inputs and compares the output with LC_ALL=C sort:
+# the plain sort on 1, 2 and 8 threads, --lcp, --front-coded and --merge.
+# Usage: check_a1m.sh A1M WORK_DIR
+set -u
+a1m=$1
+work=$2
+mkdir -p "$work"
+cd "$work" || exit 1
+LC_ALL=C
+export LC_ALL
+
+# count line, then the strings: random, with many duplicates, sharing a
+# 4000-byte prefix, a staircase a, ab, aab, ... and with spaces. The empty
+# input has a count of 0.
+awk 'BEGIN { srand(1); c = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!#%&*+-.:;=?@^_~";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = 1 + int(rand() * 30);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > random.txt
+awk 'BEGIN { srand(3); n = 20000; print n;
+             for (i = 0; i < n; i++) print "key" int(rand() * 50) }' > duplicates.txt
+awk 'BEGIN { srand(4); p = sprintf("%4000s", ""); gsub(/ /, "x", p); n = 300; print n;
+             for (i = 0; i < n; i++) print p int(rand() * 1000) }' > deep.txt
+awk 'BEGIN { n = 3000; print n; s = "";
+             for (i = 0; i < n; i++) { print s "b"; s = s "a" } }' > staircase.txt
+awk 'BEGIN { srand(6); c = "ab c";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 8);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > spaces.txt
+echo 0 > empty.txt
+
+status=0
+fail() {
+    echo "FAIL: $*"
+    status=1
+}
+
+for input in random duplicates deep staircase spaces empty; do
+    tail -n +2 "$input.txt" | sort > expected.txt
+    for threads in 1 2 8; do
+        "$a1m" --threads $threads < "$input.txt" > actual.txt || fail "a1m --threads $threads exits non-zero on $input"
+        cmp -s expected.txt actual.txt || fail "a1m --threads $threads on $input"
+    done
+
+    # --lcp prints "position<TAB>lcp<TAB>string": the strings must come out
+    # sorted, every position must name its string in the input, and every
+    # lcp must be that of the string with the one before it.
+    "$a1m" --lcp --threads 2 < "$input.txt" > lcp.txt 2> /dev/null || fail "a1m --lcp exits non-zero on $input"
+    cut -f3- lcp.txt > actual.txt
+    cmp -s expected.txt actual.txt || fail "a1m --lcp order on $input"
+    tail -n +2 "$input.txt" | awk -F'\t' '
+        NR == FNR { line[NR - 1] = $0; next }
+        { str = $0; sub(/^[^\t]*\t[^\t]*\t/, "", str);
+          if (line[$1] != str) { print "position " $1; exit 1 }
+          lcp = 0;
+          if (FNR > 1) while (lcp < length(str) && lcp < length(previous) &&
+                              substr(str, lcp + 1, 1) == substr(previous, lcp + 1, 1)) lcp++;
+          if ($2 != lcp) { print "lcp of line " FNR; exit 1 }
+          previous = str }' - lcp.txt > /dev/null || fail "a1m --lcp positions or lcps on $input"
+
+    # A front-coded file is read back by --merge, alone or with a plain one.
+    "$a1m" --front-coded < "$input.txt" > sorted.fc || fail "a1m --front-coded exits non-zero on $input"
+    "$a1m" --merge sorted.fc > actual.txt || fail "a1m --merge of a front-coded file exits non-zero on $input"
+    cmp -s expected.txt actual.txt || fail "a1m --front-coded on $input"
+done
+
+# Two halves sorted on their own and merged, plain with plain and front-coded
+# with plain, also with --front-coded after the file list.
+tail -n +2 random.txt > lines.txt
+sort lines.txt > expected.txt
+head -n 10000 lines.txt > first.txt
+tail -n +10001 lines.txt > second.txt
+{ wc -l < first.txt; cat first.txt; } | "$a1m" > first_sorted.txt
+{ wc -l < second.txt; cat second.txt; } | "$a1m" > second_sorted.txt
+{ wc -l < second.txt; cat second.txt; } | "$a1m" --front-coded > second_sorted.fc
+"$a1m" --merge first_sorted.txt second_sorted.txt > actual.txt || fail "a1m --merge exits non-zero"
+cmp -s expected.txt actual.txt || fail "a1m --merge of two plain files"
+"$a1m" --merge first_sorted.txt second_sorted.fc > actual.txt || fail "a1m --merge of mixed files exits non-zero"
+cmp -s expected.txt actual.txt || fail "a1m --merge of a plain and a front-coded file"
+"$a1m" --merge first_sorted.txt second_sorted.fc --front-coded > merged.fc ||
+    fail "a1m --merge ... --front-coded exits non-zero"
+"$a1m" --merge merged.fc > actual.txt
+cmp -s expected.txt actual.txt || fail "a1m --merge with --front-coded after the files"
+
+# --stats leaves the output alone and prints the phases to stderr.
+"$a1m" --stats < random.txt > actual.txt 2> stats.txt || fail "a1m --stats exits non-zero"
+cmp -s expected.txt actual.txt || fail "a1m --stats"
+grep -q '^sort,' stats.txt || fail "a1m --stats prints no sort phase"
+
+# A missing file and a front-coded file cut short fail the merge.
+if "$a1m" --merge first_sorted.txt "$work/missing.txt" > /dev/null 2>&1; then
+    fail "a1m --merge accepts a missing file"
+fi
+head -c $(($(wc -c < second_sorted.fc) - 3)) second_sorted.fc > truncated.fc
+if "$a1m" --merge truncated.fc > /dev/null 2>&1; then
+    fail "a1m --merge accepts a truncated front-coded file"
+fi
+
+[ $status -eq 0 ] && echo "a1m agrees with sort"
+exit $status
@@ -0,0 +1,71 @@
+#!/bin/sh
+# Runs a1q --top K and --select K for K = 0, 1, n / 2, n and n + 1 and
+# compares the output with LC_ALL=C sort | head and sort | sed -n Kp.
+# Usage: check_a1q.sh A1Q WORK_DIR
+set -u
+a1q=$1
+work=$2
+mkdir -p "$work"
+cd "$work" || exit 1
+LC_ALL=C
+export LC_ALL
+
+# count line, then the strings: random, with many duplicates, all equal,
+# with spaces and empty strings, and a single string.
+awk 'BEGIN { srand(1); c = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!#%&*+-.:;=?@^_~";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = 1 + int(rand() * 30);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > random.txt
+awk 'BEGIN { srand(3); n = 20000; print n;
+             for (i = 0; i < n; i++) print "key" int(rand() * 5) }' > duplicates.txt
+awk 'BEGIN { n = 5000; print n;
+             for (i = 0; i < n; i++) print "same" }' > equal.txt
+awk 'BEGIN { srand(6); c = "ab c";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 4);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > spaces.txt
+printf '1\nonly\n' > single.txt
+
+status=0
+fail() {
+    echo "FAIL: $*"
+    status=1
+}
+
+for input in random duplicates equal spaces single; do
+    tail -n +2 "$input.txt" | sort > sorted.txt
+    n=$(wc -l < sorted.txt)
+    for k in 0 1 $((n / 2)) $n $((n + 1)); do
+        head -n $k sorted.txt > expected.txt
+        "$a1q" --top $k < "$input.txt" > actual.txt || fail "a1q --top $k exits non-zero on $input"
+        cmp -s expected.txt actual.txt || fail "a1q --top $k on $input"
+    done
+    for k in 1 $((n / 2 + 1)) $n; do
+        sed -n "${k}p" sorted.txt > expected.txt
+        "$a1q" --select $k < "$input.txt" > actual.txt || fail "a1q --select $k exits non-zero on $input"
+        cmp -s expected.txt actual.txt || fail "a1q --select $k on $input"
+    done
+    # There is no 0-th or (n + 1)-th smallest string.
+    for k in 0 $((n + 1)); do
+        if "$a1q" --select $k < "$input.txt" > actual.txt 2> /dev/null; then
+            fail "a1q --select $k accepted on $input"
+        fi
+        [ -s actual.txt ] && fail "a1q --select $k prints a string on $input"
+    done
+done
+
+# --stats leaves the output alone and prints the phases to stderr.
+tail -n +2 random.txt | sort | head -n 100 > expected.txt
+"$a1q" --top 100 --stats < random.txt > actual.txt 2> stats.txt || fail "a1q --stats exits non-zero"
+cmp -s expected.txt actual.txt || fail "a1q --top 100 --stats"
+grep -q '^sort,' stats.txt || fail "a1q --stats prints no sort phase"
+
+echo 0 > empty.txt
+"$a1q" --top 1 < empty.txt > actual.txt || fail "a1q --top 1 exits non-zero on empty input"
+[ -s actual.txt ] && fail "a1q --top 1 prints a string on empty input"
+if "$a1q" --select 1 < empty.txt > /dev/null 2>&1; then
+    fail "a1q --select 1 accepted on empty input"
+fi
+
+[ $status -eq 0 ] && echo "a1q agrees with sort"
+exit $status
@@ -0,0 +1,78 @@
+#!/bin/sh
+# Runs a1r with every --alphabet on inputs inside and outside each alphabet
+# and compares the output with LC_ALL=C sort. Usage: check_a1r.sh A1R WORK_DIR
+set -u
+a1r=$1
+work=$2
+mkdir -p "$work"
+cd "$work" || exit 1
+LC_ALL=C
+export LC_ALL
+
+# count line, then the strings: DNA bases, decimal digits, base64, a large
+# DNA input past the packed-digit thresholds, and strings that leave every
+# alphabet now and then: N and lower case among the bases, signs, spaces and
+# bytes above 127 (0xff too) among the digits, and spaces and empty strings.
+awk 'BEGIN { srand(1); n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 16);
+                 for (j = 0; j < l; j++) s = s substr("ACGT", 1 + int(rand() * 4), 1); print s } }' > dna.txt
+awk 'BEGIN { srand(2); n = 100000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = 1 + int(rand() * 20);
+                 for (j = 0; j < l; j++) s = s substr("ACGT", 1 + int(rand() * 4), 1); print s } }' > large.txt
+awk 'BEGIN { srand(3); n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 10);
+                 for (j = 0; j < l; j++) s = s int(rand() * 10); print s } }' > digits.txt
+awk 'BEGIN { srand(4); c = "+/0123456789=ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = 1 + int(rand() * 12);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > base64.txt
+awk 'BEGIN { srand(5); n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 12);
+                 for (j = 0; j < l; j++) s = s substr(rand() < 0.05 ? "Nnacgt" : "ACGT", 1 + int(rand() * 4), 1);
+                 print s } }' > dna_other.txt
+awk 'BEGIN { srand(6); n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 10);
+                 for (j = 0; j < l; j++) {
+                     r = rand();
+                     if (r < 0.03) s = s sprintf("%c", 128 + int(rand() * 128));
+                     else if (r < 0.05) s = s sprintf("%c", 255);
+                     else if (r < 0.1) s = s substr("-. ", 1 + int(rand() * 3), 1);
+                     else s = s int(rand() * 10) }
+                 print s } }' > digits_other.txt
+awk 'BEGIN { srand(7); c = "ab c";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 8);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > spaces.txt
+
+status=0
+fail() {
+    echo "FAIL: $*"
+    status=1
+}
+
+for input in dna large digits base64 dna_other digits_other spaces; do
+    tail -n +2 "$input.txt" | sort > expected.txt
+    for alphabet in byte dna digits base64 printable; do
+        "$a1r" --alphabet $alphabet < "$input.txt" > actual.txt ||
+            fail "a1r --alphabet $alphabet exits non-zero on $input"
+        cmp -s expected.txt actual.txt || fail "a1r --alphabet $alphabet on $input"
+    done
+    "$a1r" --input "$input.txt" --alphabet dna > actual.txt || fail "a1r --input exits non-zero on $input"
+    cmp -s expected.txt actual.txt || fail "a1r --input on $input"
+done
+
+# --stats leaves the output alone and prints the phases to stderr.
+tail -n +2 dna.txt | sort > expected.txt
+"$a1r" --alphabet dna --stats < dna.txt > actual.txt 2> stats.txt || fail "a1r --stats exits non-zero"
+cmp -s expected.txt actual.txt || fail "a1r --alphabet dna --stats"
+grep -q '^sort,' stats.txt || fail "a1r --stats prints no sort phase"
+
+if "$a1r" --alphabet hex < dna.txt > /dev/null 2>&1; then
+    fail "a1r accepts an unknown alphabet"
+fi
+if "$a1r" --input "$work/missing.txt" > /dev/null 2>&1; then
+    fail "a1r accepts a missing input file"
+fi
+
+[ $status -eq 0 ] && echo "a1r agrees with sort"
+exit $status
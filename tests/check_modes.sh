@@ -0,0 +1,87 @@
+#!/bin/sh
+# Runs a1rq in each of its modes on generated inputs and compares the output
+# with LC_ALL=C sort. Usage: check_modes.sh A1RQ WORK_DIR
+set -u
+a1rq=$1
+work=$2
+mkdir -p "$work"
+cd "$work" || exit 1
+LC_ALL=C
+export LC_ALL
+
+# count line, then the strings: random, with many duplicates, sharing a
+# 4000-byte prefix, and a staircase a, ab, aab, ... whose prefixes keep
+# growing, and with embedded, leading and trailing spaces, which every way
+# of reading the input keeps. "large" is past the wide-digit and sample sort
+# thresholds.
+awk 'BEGIN { srand(1); c = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!#%&*+-.:;=?@^_~";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = 1 + int(rand() * 30);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > random.txt
+awk 'BEGIN { srand(2); n = 80000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = 1 + int(rand() * 12);
+                 for (j = 0; j < l; j++) s = s substr("ACGT", 1 + int(rand() * 4), 1); print s } }' > large.txt
+awk 'BEGIN { srand(3); n = 20000; print n;
+             for (i = 0; i < n; i++) print "key" int(rand() * 50) }' > duplicates.txt
+awk 'BEGIN { srand(4); p = sprintf("%4000s", ""); gsub(/ /, "x", p); n = 300; print n;
+             for (i = 0; i < n; i++) print p int(rand() * 1000) }' > deep.txt
+awk 'BEGIN { n = 3000; print n; s = "";
+             for (i = 0; i < n; i++) { print s "b"; s = s "a" } }' > staircase.txt
+awk 'BEGIN { srand(6); c = "ab c";
+             n = 20000; print n;
+             for (i = 0; i < n; i++) { s = ""; l = int(rand() * 8);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1); print s } }' > spaces.txt
+awk 'BEGIN { srand(5); c = "abcdeABCDE0123";
+             for (i = 0; i < 20000; i++) { s = ""; l = 1 + int(rand() * 6);
+                 for (j = 0; j < l; j++) s = s substr(c, 1 + int(rand() * length(c)), 1);
+                 print i "," s } }' > records.txt
+
+status=0
+fail() {
+    echo "FAIL: $*"
+    status=1
+}
+
+for input in random large duplicates deep staircase spaces; do
+    tail -n +2 "$input.txt" | sort > expected.txt
+    for mode in "" "--threads 4" "--sample" "--stable" "--burst" "--cached" "--adaptive" \
+                "--alphabet printable" "--incremental 1000" "--external --memory-limit 20000"; do
+        # shellcheck disable=SC2086
+        "$a1rq" $mode < "$input.txt" > actual.txt || fail "a1rq $mode exits non-zero on $input"
+        cmp -s expected.txt actual.txt || fail "a1rq $mode on $input"
+    done
+    head -n 100 expected.txt > expected_top.txt
+    "$a1rq" --top 100 < "$input.txt" > actual.txt || fail "a1rq --top exits non-zero on $input"
+    cmp -s expected_top.txt actual.txt || fail "a1rq --top 100 on $input"
+    "$a1rq" --input "$input.txt" > actual.txt || fail "a1rq --input exits non-zero on $input"
+    cmp -s expected.txt actual.txt || fail "a1rq --input on $input"
+    uniq -c expected.txt | sed 's/^ *\([0-9]*\) /\1	/' > expected_unique.txt
+    "$a1rq" --unique < "$input.txt" > actual.txt || fail "a1rq --unique exits non-zero on $input"
+    cmp -s expected_unique.txt actual.txt || fail "a1rq --unique on $input"
+done
+
+# Records keep their whole line; --stable makes the order of equal keys
+# that of sort -s.
+sort -s -t, -k2,2 records.txt > expected.txt
+"$a1rq" --key-field 2 --delimiter , --stable < records.txt > actual.txt
+cmp -s expected.txt actual.txt || fail "a1rq --key-field 2 --delimiter , --stable"
+cut -d, -f2 records.txt > keys.txt
+sort -s -f keys.txt > expected.txt
+"$a1rq" --key-bytes 0 --collation ci --stable < keys.txt > actual.txt
+cmp -s expected.txt actual.txt || fail "a1rq --collation ci --stable"
+
+if "$a1rq" --external --input "$work/missing.txt" > /dev/null 2>&1; then
+    fail "a1rq --external accepts a missing input file"
+fi
+
+# A run that cannot be spilled fails the sort and leaves no run files behind.
+mkdir -p spill
+if "$a1rq" --external --memory-limit 20000 --temp-dir "$work/missing/dir" < random.txt > /dev/null 2>&1; then
+    fail "a1rq --external accepts an unwritable --temp-dir"
+fi
+"$a1rq" --external --memory-limit 20000 --temp-dir "$work/spill" < random.txt > /dev/null ||
+    fail "a1rq --external --temp-dir exits non-zero"
+[ -z "$(ls spill)" ] || fail "a1rq --external leaves run files in --temp-dir"
+
+[ $status -eq 0 ] && echo "all modes agree with sort"
+exit $status
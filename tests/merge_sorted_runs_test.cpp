@@ -0,0 +1,104 @@
+// Merges sorted runs with mergeSortedRuns and checks the result against a
+// stable sort of the concatenated runs: empty runs, no runs at all,
+// duplicates inside and across runs, and keys reached through a projection.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stringsort/loser_tree.hpp"
+
+using stringsort::mergeSortedRuns;
+using namespace std::literals;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+// A string together with the run it came from, to see the order of ties.
+struct Tagged {
+    std::string key;
+    int run;
+};
+
+using Runs = std::vector<std::vector<std::string>>;
+
+std::vector<std::string> merged(const Runs& runs) {
+    std::vector<std::pair<Runs::value_type::const_iterator, Runs::value_type::const_iterator>> ranges;
+    for (const auto& run : runs)
+        ranges.emplace_back(run.begin(), run.end());
+    std::vector<std::string> result;
+    mergeSortedRuns(ranges, std::back_inserter(result));
+    return result;
+}
+
+std::vector<std::string> expected(const Runs& runs) {
+    std::vector<std::string> result;
+    for (const auto& run : runs)
+        result.insert(result.end(), run.begin(), run.end());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+int main() {
+    check(merged({}).empty(), "no runs merge to nothing");
+    check(merged({{}, {}, {}}).empty(), "empty runs merge to nothing");
+
+    const Runs small = {{}, {"a", "a", "b"}, {}, {"", "a", "c"}, {"b"}, {}};
+    check(merged(small) == expected(small), "small runs with empty runs and duplicates");
+    const Runs one = {{"", "", "x", "xy"}};
+    check(merged(one) == one[0], "a single run is copied");
+
+    std::mt19937 gen(11);
+    int round = 0;
+    while (round < 200) {
+        Runs runs(gen() % 12);
+        for (auto& run : runs) {
+            run.resize(gen() % 4 == 0 ? 0 : gen() % 50);
+            for (std::string& str : run) {
+                str = std::string(gen() % 3 == 0 ? 10 : 0, 'p');
+                const int length = gen() % 4;
+                int i = 0;
+                while (i < length) {
+                    str.push_back("ab\0"[gen() % 3]);
+                    i++;
+                }
+            }
+            std::sort(run.begin(), run.end());
+        }
+        check(merged(runs) == expected(runs), "random runs, round " + std::to_string(round));
+        round++;
+    }
+
+    // Equal keys keep the order of their runs, also through a projection.
+    const std::vector<std::vector<Tagged>> tagged = {
+        {{"a", 0}, {"b", 0}}, {}, {{"a", 2}, {"a", 2}, {"c", 2}}, {{"b", 3}}
+    };
+    std::vector<std::pair<std::vector<Tagged>::const_iterator, std::vector<Tagged>::const_iterator>> ranges;
+    for (const auto& run : tagged)
+        ranges.emplace_back(run.begin(), run.end());
+    std::vector<Tagged> result(6);
+    auto end = mergeSortedRuns(ranges, result.begin(), &Tagged::key);
+    check(end == result.end(), "the output ends after every element");
+    std::vector<std::pair<std::string_view, int>> order;
+    for (const Tagged& item : result)
+        order.emplace_back(item.key, item.run);
+    check(order == std::vector<std::pair<std::string_view, int>>{
+              {"a"sv, 0}, {"a"sv, 2}, {"a"sv, 2}, {"b"sv, 0}, {"b"sv, 3}, {"c"sv, 2}},
+          "ties come out in the order of their runs");
+
+    if (failures == 0)
+        std::cout << "mergeSortedRuns ok\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,96 @@
+// Inserts batches into a SortedStringStore and checks size, tier count,
+// lookups and scans against a sorted copy of everything inserted.
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stringsort/sorted_string_store.hpp"
+
+using stringsort::SortedStringStore;
+using stringsort::StringVector;
+using namespace std::literals;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+std::vector<std::string> scanned(const SortedStringStore& store, std::string_view low, std::string_view high) {
+    std::vector<std::string> result;
+    store.scan(low, high, [&result](std::string_view str) { result.emplace_back(str); });
+    return result;
+}
+
+std::vector<std::string> scannedFrom(const SortedStringStore& store, std::string_view low) {
+    std::vector<std::string> result;
+    store.scanFrom(low, [&result](std::string_view str) { result.emplace_back(str); });
+    return result;
+}
+
+int main() {
+    SortedStringStore store;
+    check(store.size() == 0 && store.tierCount() == 0, "a new store is empty");
+    check(!store.contains(""), "a new store contains nothing");
+    check(scannedFrom(store, "").empty(), "a new store scans nothing");
+
+    std::mt19937 gen(7);
+    std::vector<std::string> inserted;
+    int batch_count = 0;
+    while (batch_count < 300) {
+        // The batch owns its strings only until insert returns.
+        std::vector<std::string> batch(1 + gen() % 40);
+        for (std::string& str : batch) {
+            str = std::string(gen() % 4 == 0 ? 20 : 0, 'p');
+            const int length = gen() % 6;
+            int i = 0;
+            while (i < length) {
+                str.push_back("abc\0z"[gen() % 5]);
+                i++;
+            }
+        }
+        store.insert(StringVector(batch.begin(), batch.end()));
+        inserted.insert(inserted.end(), batch.begin(), batch.end());
+        batch_count++;
+    }
+    store.insert({});
+    std::sort(inserted.begin(), inserted.end());
+
+    check(store.size() == inserted.size(), "size counts every inserted string");
+    // Every tier is more than twice as large as the next newer one.
+    check(store.tierCount() <= static_cast<size_t>(std::bit_width(inserted.size())), "tiers grow geometrically");
+    check(scannedFrom(store, "") == inserted, "a full scan returns every string in order");
+
+    for (std::string_view low : {""sv, "a"sv, "ab"sv, "b"sv, "c\0"sv, "pppp"sv, "zzz"sv}) {
+        for (std::string_view high : {"", "abc", "b", "pppppppppppppppppppppa", "~"}) {
+            std::vector<std::string> expected;
+            for (const std::string& str : inserted) {
+                if (str >= low && str < high)
+                    expected.push_back(str);
+            }
+            check(scanned(store, low, high) == expected,
+                  "scan [" + std::string(low) + ", " + std::string(high) + ")");
+        }
+        const auto first = std::lower_bound(inserted.begin(), inserted.end(), low);
+        check(scannedFrom(store, low) == std::vector<std::string>(first, inserted.end()),
+              "scanFrom " + std::string(low));
+    }
+
+    for (const std::string& str : inserted)
+        check(store.contains(str), "contains " + str);
+    for (std::string_view absent : {"abcabcabc", "d", "pppp", "zzzzzzz"})
+        check(!store.contains(absent), "does not contain " + std::string(absent));
+
+    if (failures == 0)
+        std::cout << "SortedStringStore ok\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}